@@ -5,12 +5,20 @@
 
 #include "sprite.h"
 
+#define LZ77_HEADER 0x10
+#define FAST_LZ_HEADER 0x40
+
+#define ASYNC_DECOMPRESS_BYTES_PER_FRAME 0x1000
+
+typedef void (*AsyncDecompressCallback)(void *dest, u32 size);
+
 extern u8 gDecompressionBuffer[0x4000];
 
 void LZDecompressWram(const void *src, void *dest);
 void LZDecompressVram(const void *src, void *dest);
 
 u32 IsLZ77Data(const void *ptr, u32 minSize, u32 maxSize);
+u32 IsCompressedData(const void *ptr, u32 minSize, u32 maxSize);
 
 u16 LoadCompressedSpriteSheet(const struct CompressedSpriteSheet *src);
 u16 LoadCompressedSpriteSheetByTemplate(const struct SpriteTemplate *template, s32 offset);
@@ -31,4 +39,11 @@ void LoadSpecialPokePic(void *dest, s32 species, u32 personality, bool8 isFrontP
 
 u32 GetDecompressedDataSize(const u32 *ptr);
 
+void RequestAsyncLZDecompressWram(const void *src, void *dest, AsyncDecompressCallback callback);
+void RequestAsyncLZDecompressVram(const void *src, void *dest, AsyncDecompressCallback callback);
+bool32 IsAsyncDecompressionActive(void);
+void RunAsyncDecompression(u32 maxBytes);
+void FinishAsyncDecompression(void);
+void CancelAsyncDecompression(void);
+
 #endif // GUARD_DECOMPRESS_H
@@ -12,6 +12,17 @@
 #define DMA3_16BIT 0
 #define DMA3_32BIT 1
 
+// Requests are processed by the priority of their destination, but
+// never before an earlier request which writes to or reads from the
+// same bytes.
+enum
+{
+    DMA3_PRIORITY_HIGH,   // palettes and OAM
+    DMA3_PRIORITY_NORMAL, // anything else
+    DMA3_PRIORITY_LOW,    // VRAM
+    DMA3_PRIORITY_COUNT,
+};
+
 #define Dma3CopyLarge_(src, dest, size, bit)               \
 {                                                          \
     const void *_src = src;                                \
@@ -58,11 +69,14 @@
 void ClearDma3Requests(void);
 
 // Handle pending DMA3 requests
+// Stops after 40 KiB or at the end of v-blank, and the rest are deferred
+// to the next frame
 void ProcessDma3Requests(void);
 
 // Copy size bytes from src to dest.
 // mode takes a DMA3_*BIT macro
-// Returns the request index
+// Returns the request index, which may be that of an earlier request to
+// the same destination that this one was merged into
 s16 RequestDma3Copy(const void *src, void *dest, u16 size, u8 mode);
 
 // Fill size bytes at dest with value.
@@ -76,4 +90,9 @@ s16 RequestDma3Fill(s32 value, void *dest, u16 size, u8 mode);
 // Returns -1 if pending, 0 otherwise
 s16 WaitDma3Request(s16 index);
 
+#if PROFILE
+// Print how many requests were merged and deferred since the last call
+void PrintDma3Stats(void);
+#endif
+
 #endif // GUARD_DMA3_H
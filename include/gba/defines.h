@@ -11,10 +11,19 @@
 #define EWRAM_DATA __attribute__((section(".sbss")))
 #define IWRAM_INIT __attribute__((section(".iwram")))
 #define EWRAM_INIT __attribute__((section(".ewram")))
+// Const tables which are read in tight loops can be copied to RAM at boot
+// along with IWRAM_INIT and EWRAM_INIT, so that reading them does not wait
+// on the cartridge. They take up both RAM and ROM, see `make memreport`.
+#define IWRAM_RODATA __attribute__((section(".iwram.rodata")))
+#define EWRAM_RODATA __attribute__((section(".ewram.rodata")))
 #define COMMON_DATA __attribute__((section("common_data")))
 #define UNUSED __attribute__((unused))
 
 #define ARM_FUNC __attribute__((target("arm")))
+// Functions in IWRAM run as ARM code, with 32-bit loads and no wait states.
+// They are out of range of a bl from ROM, so they are called through a
+// register.
+#define IWRAM_CODE __attribute__((section(".iwram.code"), target("arm"), long_call, noinline))
 
 #if MODERN
 #define NOINLINE __attribute__((noinline))
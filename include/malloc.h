@@ -19,7 +19,8 @@ struct MemBlock {
     // Whether this block is currently allocated.
     bool16 allocated:1;
 
-    u16 unused_00:4;
+    // The heap arena that this block was allocated in, or 0 if none.
+    u16 arena:4;
 
     // High 11 bits of location pointer.
     u16 locationHi:11;
@@ -44,6 +45,7 @@ struct MemBlock {
 };
 
 #define HEAP_SIZE 0x1C000
+#define MAX_HEAP_ARENAS 15
 extern u8 gHeap[];
 
 #if TESTING || !defined(NDEBUG)
@@ -62,8 +64,23 @@ void *Alloc_(u32 size, const char *location);
 void *AllocZeroed_(u32 size, const char *location);
 void Free(void *pointer);
 void InitHeap(void *pointer, u32 size);
+u32 PushHeapArena(void);
+void FreeHeapArena(u32 arena);
+bool32 CheckHeap(void);
 
 const struct MemBlock *HeapHead(void);
 const char *MemBlockLocation(const struct MemBlock *block);
 
+// Prints the largest free block and every allocated block with its call
+// site over the debug log. Profiling builds (make profile) also print each
+// call site's live bytes, peak bytes, allocations and failed allocations,
+// and the fragmentation sampled each time the main callback changed.
+void HeapStats_Print(void);
+
+#if PROFILE
+void HeapStats_SampleFragmentation(void (*callback)(void));
+#else
+#define HeapStats_SampleFragmentation(callback) (void)0
+#endif
+
 #endif // GUARD_MALLOC_H
@@ -0,0 +1,52 @@
+#ifndef GUARD_PROFILE_H
+#define GUARD_PROFILE_H
+
+// Frame profiler, built with `make profile` (or PROFILE=1).
+//
+// Times the main callbacks, each task, AnimateSprites, BuildOamBuffer and
+// the v-blank handler with timers 1 and 2 cascaded into a cycle counter,
+// and every PROFILE_REPORT_FRAMES frames prints a per-function summary
+// over the debug log (see LOG_HANDLER). Functions are printed as their
+// addresses, which can be looked up in the .map or .sym.
+//
+// Times are inclusive (e.g. CB2 includes the tasks and sprites it runs)
+// except that v-blank is subtracted from everything that it interrupts.
+//
+// The heap also keeps per call site statistics in this build, which are
+// printed on demand by HeapStats_Print (see malloc.h), and the DMA3
+// manager counts merged and deferred requests, which are printed with the
+// summary.
+
+#define PROFILE_REPORT_FRAMES 300
+
+enum ProfileKind
+{
+    PROFILE_FRAME,
+    PROFILE_CALLBACK1,
+    PROFILE_CALLBACK2,
+    PROFILE_TASK,
+    PROFILE_ANIMATE_SPRITES,
+    PROFILE_BUILD_OAM_BUFFER,
+    PROFILE_VBLANK,
+    PROFILE_KINDS_COUNT,
+};
+
+#if PROFILE
+
+u32 Profile_Begin(void);
+void Profile_End(enum ProfileKind kind, const void *func, u32 begin);
+u32 Profile_BeginInterrupt(void);
+void Profile_EndInterrupt(enum ProfileKind kind, const void *func, u32 begin);
+void Profile_EndFrame(void);
+
+#else
+
+#define Profile_Begin(...) (u32)0
+#define Profile_End(kind, func, begin) (void)(begin)
+#define Profile_BeginInterrupt(...) (u32)0
+#define Profile_EndInterrupt(kind, func, begin) (void)(begin)
+#define Profile_EndFrame(...) (void)0
+
+#endif
+
+#endif // GUARD_PROFILE_H
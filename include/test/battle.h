@@ -150,7 +150,8 @@
  *
  * PARAMETRIZE causes a test to run multiple times, once per PARAMETRIZE
  * block (e.g. once with raiseAttack = FALSE and once with raiseAttack =
- * TRUE).
+ * TRUE). If the test has no results, each PARAMETRIZE may run in a
+ * different process.
  * HP_BAR's captureDamage causes the change in HP to be stored in a
  * variable, and the variable chosen is results[i].damage. results[i]
  * contains all the variables defined at the end of SINGLE_BATTLE_TEST,
@@ -268,7 +269,25 @@
  *     PASSES_RANDOMLY(GetMoveAccuracy(move), 100);
  * Note that this mode of PASSES_RANDOMLY makes the tests run very
  * slowly and should be avoided where possible. If the mechanic you are
- * testing is missing its tag, you should add it.
+ * testing is missing its tag, you should add it. To reduce the impact,
+ * the trials are split into ranges of BATTLE_TEST_TRIALS_PER_SHARD
+ * which may run in different processes.
+ *
+ * An untagged PASSES_RANDOMLY can instead stop as soon as the results
+ * are conclusive, using a sequential probability ratio test:
+ *     PASSES_RANDOMLY(GetMoveAccuracy(move), 100, .sequential = TRUE);
+ * The test passes if the pass ratio is consistent with the expected
+ * ratio, and fails if it is consistent with the expected ratio +/-
+ * delta. alpha bounds the chance of failing a correct test against
+ * each alternative, and beta the chance of passing an incorrect one.
+ * They default to
+ * BATTLE_TEST_SEQUENTIAL_ALPHA/BETA/DELTA and can be changed, e.g.:
+ *     PASSES_RANDOMLY(1, 4, .sequential = TRUE, .delta = Q_4_12(0.1));
+ * If neither is conclusive after 50 trials, the test passes if the
+ * results are closer to the expected ratio. Sequential tests run in a
+ * single process. .maxTrials instead fails the test if neither is
+ * conclusive after that many trials:
+ *     PASSES_RANDOMLY(1, 2, .sequential = TRUE, .maxTrials = 25);
  *
  * GIVEN
  * Contains the initial state of the parties before the battle.
@@ -322,6 +341,32 @@
  * The most common combination is  AI_FLAGS(AI_FLAG_CHECK_BAD_MOVE | AI_FLAG_CHECK_VIABILITY | AI_FLAG_TRY_TO_FAINT)
  * which is the general 'smart' AI.
  *
+ * AI_VS_AI
+ * The player's battlers are also controlled by the AI, with the same
+ * AI_FLAGS as the opponent's, and the battle runs until one side wins,
+ * or for at most AI_VS_AI_MAX_TURNS turns, so there are no TURNs. The
+ * time that the AI spends deciding each turn, the number of turns and
+ * the outcomes are summed over the trials and parameters of the test,
+ * and by Hydra over its shards, and printed with its result. Has use
+ * only for AI tests. For example:
+ *     AI_SINGLE_BATTLE_TEST("AI_VS_AI: Lorelei vs Bruno")
+ *     {
+ *         PASSES_RANDOMLY(100, 100);
+ *         GIVEN {
+ *             AI_VS_AI;
+ *             AI_FLAGS(AI_FLAG_CHECK_BAD_MOVE | AI_FLAG_CHECK_VIABILITY | AI_FLAG_TRY_TO_FAINT);
+ *             PLAYER_TRAINER_PARTY(TRAINER_ELITE_FOUR_LORELEI);
+ *             OPPONENT_TRAINER_PARTY(TRAINER_ELITE_FOUR_BRUNO);
+ *         }
+ *     }
+ * runs 50 battles with different seeds. See test/benchmark/ai_vs_ai.c
+ * and `make ai-benchmark`.
+ *
+ * PLAYER_TRAINER_PARTY(trainerId) and OPPONENT_TRAINER_PARTY(trainerId)
+ * Replaces the player's or opponent's party respectively with the party
+ * of a trainer from src/data/trainers.party, as it would be created for
+ * a battle against that trainer. Has use only for AI_VS_AI tests.
+ *
  * WHEN
  * Contains the choices that battlers make during the battle.
  *
@@ -520,6 +565,10 @@
 #define MAX_TURNS 16
 #define MAX_QUEUED_EVENTS 30
 #define MAX_EXPECTED_ACTIONS 10
+#define BATTLE_TEST_TRIALS_PER_SHARD 10
+#define BATTLE_TEST_SEQUENTIAL_ALPHA Q_4_12(0.05)
+#define BATTLE_TEST_SEQUENTIAL_BETA Q_4_12(0.05)
+#define BATTLE_TEST_SEQUENTIAL_DELTA Q_4_12(0.2)
 
 enum { BATTLE_TEST_SINGLES, BATTLE_TEST_DOUBLES, BATTLE_TEST_WILD, BATTLE_TEST_AI_SINGLES, BATTLE_TEST_AI_DOUBLES };
 
@@ -663,6 +712,7 @@ struct BattleTrialData
     u8 lastActionTurn;
     u8 queuedEvent;
     u8 aiActionsPlayed[MAX_BATTLERS_COUNT];
+    bool8 reachedMaxTurns;
 };
 
 struct BattleTestData
@@ -690,6 +740,7 @@ struct BattleTestData
     u8 moveBattlers;
     bool8 hasAI:1;
     bool8 logAI:1;
+    bool8 aiVsAi:1;
 
     struct RecordedBattleSave recordedBattle;
     u8 battleRecordTypes[MAX_BATTLERS_COUNT][BATTLER_RECORD_SIZE];
@@ -712,6 +763,46 @@ struct BattleTestData
     struct BattleTrialData trial;
 };
 
+// Log-likelihood ratios (in 1/65536ths of a bit) of the pass ratio
+// being expectedRatio - delta or expectedRatio + delta rather than
+// expectedRatio.
+struct SequentialTrials
+{
+    s32 llr[2];
+    s32 passLlr[2];
+    s32 failLlr[2];
+    s32 acceptBound;
+    s32 rejectBound;
+    u16 trials;
+    u16 passes;
+    u16 maxTrials;
+    u8 accepted:2;
+    bool8 rejected:1;
+};
+
+#define AI_VS_AI_MAX_TURNS 100
+
+// Samples are counted by the position of their highest set bit, which
+// bounds their percentiles within a factor of 2.
+struct AIBenchmarkSamples
+{
+    u32 count;
+    u32 max;
+    u64 total;
+    u32 log2Counts[32];
+};
+
+struct AIBenchmarkStats
+{
+    struct AIBenchmarkSamples phases[AI_BENCHMARK_PHASES_COUNT];
+    u16 turns[AI_VS_AI_MAX_TURNS + 1];
+    u16 battles;
+    u16 won;
+    u16 lost;
+    u16 drew;
+    u16 reachedMaxTurns;
+};
+
 struct BattleTestRunnerState
 {
     u8 battlersCount;
@@ -719,6 +810,9 @@ struct BattleTestRunnerState
     u16 parametersCount; // Valid only in BattleTest_Setup.
     u16 parameters;
     u16 runParameter;
+    u16 parametersEnd; // One past the last parameter of the shard.
+    u16 trialShard;
+    u16 trialShards;
     u16 rngTag;
     u16 rngTrialOffset;
     u16 trials;
@@ -735,7 +829,10 @@ struct BattleTestRunnerState
     bool8 runFinally:1;
     bool8 runningFinally:1;
     bool8 tearDownBattle:1;
+    bool8 sequential:1;
+    struct SequentialTrials sequentialTrials;
     struct BattleTestData data;
+    struct AIBenchmarkStats aiBenchmark;
     u8 *results;
     u8 checkProgressParameter;
     u8 checkProgressTrial;
@@ -815,6 +912,11 @@ extern struct BattleTestRunnerState *const gBattleTestRunnerState;
 struct RandomlyContext
 {
     u16 tag;
+    bool8 sequential;
+    u16 alpha;
+    u16 beta;
+    u16 delta;
+    u16 maxTrials;
 };
 
 void Randomly(u32 sourceLine, u32 passes, u32 trials, struct RandomlyContext);
@@ -831,12 +933,15 @@ struct moveWithPP {
 #define RNGSeed(seed) RNGSeed_(__LINE__, seed)
 #define AI_FLAGS(flags) AIFlags_(__LINE__, flags)
 #define AI_LOG AILogScores(__LINE__)
+#define AI_VS_AI AIVsAI_(__LINE__)
 
 #define FLAG_SET(flagId) SetFlagForTest(__LINE__, flagId)
 #define WITH_CONFIG(configTag, value) TestSetConfig(__LINE__, configTag, value)
 
 #define PLAYER(species) for (OpenPokemon(__LINE__, B_SIDE_PLAYER, species); gBattleTestRunnerState->data.currentMon; ClosePokemon(__LINE__))
 #define OPPONENT(species) for (OpenPokemon(__LINE__, B_SIDE_OPPONENT, species); gBattleTestRunnerState->data.currentMon; ClosePokemon(__LINE__))
+#define PLAYER_TRAINER_PARTY(trainerId) TrainerParty_(__LINE__, B_SIDE_PLAYER, trainerId)
+#define OPPONENT_TRAINER_PARTY(trainerId) TrainerParty_(__LINE__, B_SIDE_OPPONENT, trainerId)
 
 #define Gender(gender) Gender_(__LINE__, gender)
 #define Nature(nature) Nature_(__LINE__, nature)
@@ -875,6 +980,8 @@ void ClosePokemon(u32 sourceLine);
 void RNGSeed_(u32 sourceLine, rng_value_t seed);
 void AIFlags_(u32 sourceLine, u32 flags);
 void AILogScores(u32 sourceLine);
+void AIVsAI_(u32 sourceLine);
+void TrainerParty_(u32 sourceLine, u32 side, u32 trainerId);
 void Gender_(u32 sourceLine, u32 gender);
 void Nature_(u32 sourceLine, u32 nature);
 void Ability_(u32 sourceLine, u32 ability);
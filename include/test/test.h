@@ -20,6 +20,7 @@ enum TestResult
 struct TestRunner
 {
     u32 (*estimateCost)(void *);
+    u32 (*estimateShards)(void *);
     void (*setUp)(void *);
     void (*run)(void *);
     void (*tearDown)(void *);
@@ -43,6 +44,9 @@ struct TestRunnerState
     const char *skipFilename;
     u32 failedAssumptionsBlockLine;
     const struct Test *test;
+    u16 shard;
+    u16 shardsCount;
+    u32 shardCost;
     u32 processCosts[MAX_PROCESSES];
 
     u8 result;
@@ -51,11 +55,13 @@ struct TestRunnerState
     bool8 inBenchmark:1;
     bool8 tearDown:1;
     u32 timeoutSeconds;
+    u32 startFrame;
 };
 
 extern const u8 gTestRunnerN;
 extern const u8 gTestRunnerI;
 extern const char gTestRunnerArgv[256];
+extern const char gTestRunnerFiles[4096];
 
 extern const struct TestRunner gAssumptionsRunner;
 
@@ -213,6 +219,26 @@ static inline struct Benchmark BenchmarkStop(void)
             Test_ExitWithResult(TEST_RESULT_FAIL, __LINE__, ":L%s:%d: EXPECT_SLOWER(" #a ", " #b ") failed", gTestRunnerState.test->filename, __LINE__); \
     } while (0)
 
+// Converts the ticks of a benchmark (which uses TIMER_64CLK) to cycles.
+#define BENCHMARK_CYCLES(a) ((a).ticks * 64)
+
+// Fails if benchmark a took more than cycles, e.g. to stop a hot path
+// from regressing past a known-acceptable cost.
+#define EXPECT_WITHIN_BUDGET(a, cycles) \
+    do \
+    { \
+        u32 a_ = BENCHMARK_CYCLES(a); u32 b_ = (cycles); \
+        Test_MgbaPrintf(#a ": %d cycles, budget: %d cycles", a_, b_); \
+        if (a_ > b_) \
+            Test_ExitWithResult(TEST_RESULT_FAIL, __LINE__, ":L%s:%d: EXPECT_WITHIN_BUDGET(" #a ", " #cycles ") failed: %d cycles, +%d%%", gTestRunnerState.test->filename, __LINE__, a_, b_ ? ((a_ - b_) * 100 + b_ - 1) / b_ : 100); \
+    } while (0)
+
+// Reports benchmark a to Hydra, which compares it with the baseline
+// file (see BENCHMARK_BASELINE in the Makefile) and fails the test if
+// it regressed.
+#define EXPECT_BASELINE(a) \
+    Test_MgbaPrintf(":B%d %s", BENCHMARK_CYCLES(a), #a)
+
 #define KNOWN_FAILING \
     Test_ExpectedResult(TEST_RESULT_FAIL)
 
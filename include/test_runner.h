@@ -5,6 +5,15 @@ extern const bool8 gTestRunnerEnabled;
 extern const bool8 gTestRunnerHeadless;
 extern const bool8 gTestRunnerSkipIsFail;
 
+// AI decisions timed in AI_VS_AI battle tests, see test/benchmark/ai_vs_ai.c.
+enum AIBenchmarkPhase
+{
+    AI_BENCHMARK_LOGIC_DATA,
+    AI_BENCHMARK_SWITCHING,
+    AI_BENCHMARK_CHOOSE_MOVE,
+    AI_BENCHMARK_PHASES_COUNT,
+};
+
 #if TESTING
 
 void TestRunner_Battle_RecordAbilityPopUp(u32 battlerId, u32 ability);
@@ -26,6 +35,11 @@ void TestRunner_Battle_CheckBattleRecordActionType(u32 battlerId, u32 recordInde
 u32 TestRunner_Battle_GetForcedAbility(u32 side, u32 partyIndex);
 u32 TestRunner_Battle_GetChosenGimmick(u32 side, u32 partyIndex);
 
+bool32 TestRunner_Battle_IsAiVsAi(void);
+void TestRunner_Battle_CheckTurnLimit(void);
+u32 TestRunner_Battle_AIBenchmarkStart(void);
+void TestRunner_Battle_AIBenchmarkStop(enum AIBenchmarkPhase phase, u32 start);
+
 #else
 
 #define TestRunner_Battle_RecordAbilityPopUp(...) (void)0
@@ -48,6 +62,11 @@ u32 TestRunner_Battle_GetChosenGimmick(u32 side, u32 partyIndex);
 
 #define TestRunner_Battle_GetChosenGimmick(...) (u32)0
 
+#define TestRunner_Battle_IsAiVsAi(...) FALSE
+#define TestRunner_Battle_CheckTurnLimit(...) (void)0
+#define TestRunner_Battle_AIBenchmarkStart(...) (u32)0
+#define TestRunner_Battle_AIBenchmarkStop(phase, start) (void)(start)
+
 #endif
 
 #endif
@@ -16,6 +16,8 @@ u16 CalcCRC16(const u8 *data, u32 length);
 u16 CalcCRC16WithTable(const u8 *data, u32 length);
 u32 CalcByteArraySum(const u8 *data, u32 length);
 void BlendPalette(u16 palOffset, u16 numEntries, u8 coeff, u16 blendColor);
+void BuildBlendTables(u16 *tables, u32 coeff, u32 blendColor);
+IWRAM_CODE void BlendColors(const u16 *src, u16 *dst, u32 count, const u16 *tables, u32 keepMask);
 void BlendPalettesAt(u16 * palbuff, u16 blend_pal, u32 coefficient, s32 size);
 void DoBgAffineSet(struct BgAffineDstData * dest, u32 texX, u32 texY, s16 srcX, s16 srcY, s16 sx, s16 sy, u16 alpha);
 
@@ -42,10 +42,16 @@ struct WindowTemplate
 
 #define WINDOW_NONE 0xFF
 
+// The tiles in [dirtyLeft, dirtyRight) x [dirtyTop, dirtyBottom) have
+// changed since the window was last copied to VRAM.
 struct Window
 {
     struct WindowTemplate window;
     u8 *tileData;
+    u8 dirtyLeft;
+    u8 dirtyTop;
+    u8 dirtyRight;
+    u8 dirtyBottom;
 };
 
 bool32 InitWindows(const struct WindowTemplate *templates);
@@ -55,6 +61,8 @@ void RemoveWindow(u32 windowId);
 void FreeAllWindowBuffers(void);
 void CopyWindowToVram(u32 windowId, u32 mode);
 void CopyWindowRectToVram(u32 windowId, u32 mode, u32 x, u32 y, u32 w, u32 h);
+void CopyWindowDirtyTilesToVram(u32 windowId);
+void MarkWindowDirty(u32 windowId, u32 x, u32 y, u32 width, u32 height);
 void PutWindowTilemap(u32 windowId);
 void PutWindowRectTilemapOverridePalette(u32 windowId, u8 x, u8 y, u8 width, u8 height, u8 palette);
 void ClearWindowTilemap(u32 windowId);
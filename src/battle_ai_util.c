@@ -15,6 +15,7 @@
 #include "pokemon.h"
 #include "random.h"
 #include "recorded_battle.h"
+#include "test_runner.h"
 #include "util.h"
 #include "constants/abilities.h"
 #include "constants/battle_ai.h"
@@ -58,7 +59,8 @@ bool32 AI_RandLessThan(u32 val)
 
 bool32 IsAiVsAiBattle(void)
 {
-    return (B_FLAG_AI_VS_AI_BATTLE && FlagGet(B_FLAG_AI_VS_AI_BATTLE));
+    return (B_FLAG_AI_VS_AI_BATTLE && FlagGet(B_FLAG_AI_VS_AI_BATTLE))
+        || (gTestRunnerEnabled && TestRunner_Battle_IsAiVsAi());
 }
 
 bool32 BattlerHasAi(u32 battlerId)
@@ -1577,6 +1577,7 @@ s16 CloneBattlerSpriteWithBlend(u8 animBattler)
             if (!gSprites[i].inUse)
             {
                 gSprites[i] = gSprites[spriteId];
+                MarkSpriteInUse(i);
                 gSprites[i].oam.objMode = ST_OAM_OBJ_BLEND;
                 gSprites[i].invisible = FALSE;
                 return i;
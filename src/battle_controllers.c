@@ -243,7 +243,10 @@ static void InitSinglePlayerBtlControllers(void)
             }
             else
             {
-                gBattlerControllerFuncs[0] = SetControllerToRecordedPlayer;
+                if (IsAiVsAiBattle())
+                    gBattlerControllerFuncs[0] = SetControllerToPlayerPartner;
+                else
+                    gBattlerControllerFuncs[0] = SetControllerToRecordedPlayer;
                 gBattlerPositions[0] = B_POSITION_PLAYER_LEFT;
 
                 gBattlerControllerFuncs[1] = SetControllerToOpponent;
@@ -379,10 +382,16 @@ static void InitSinglePlayerBtlControllers(void)
             }
             else if (gBattleTypeFlags & BATTLE_TYPE_IS_MASTER)
             {
-                gBattlerControllerFuncs[0] = SetControllerToRecordedPlayer;
+                if (IsAiVsAiBattle())
+                    gBattlerControllerFuncs[0] = SetControllerToPlayerPartner;
+                else
+                    gBattlerControllerFuncs[0] = SetControllerToRecordedPlayer;
                 gBattlerPositions[0] = B_POSITION_PLAYER_LEFT;
 
-                gBattlerControllerFuncs[2] = SetControllerToRecordedPlayer;
+                if (IsAiVsAiBattle())
+                    gBattlerControllerFuncs[2] = SetControllerToPlayerPartner;
+                else
+                    gBattlerControllerFuncs[2] = SetControllerToRecordedPlayer;
                 gBattlerPositions[2] = B_POSITION_PLAYER_RIGHT;
 
                 if (gBattleTypeFlags & BATTLE_TYPE_RECORDED_LINK)
@@ -3670,7 +3670,9 @@ static void TryDoEventsBeforeFirstTurn(void)
 
         memset(gQueuedStatBoosts, 0, sizeof(gQueuedStatBoosts));
         SetShellSideArmCategory();
+        u32 aiBenchmark = TestRunner_Battle_AIBenchmarkStart();
         SetAiLogicDataForTurn(AI_DATA); // get assumed abilities, hold effects, etc of all battlers
+        TestRunner_Battle_AIBenchmarkStop(AI_BENCHMARK_LOGIC_DATA, aiBenchmark);
 
         // if (gBattleTypeFlags & BATTLE_TYPE_ARENA)
         // {
@@ -3711,6 +3713,7 @@ static void HandleEndTurn_ContinueBattle(void)
 void BattleTurnPassed(void)
 {
     s32 i;
+    u32 aiBenchmark;
 
     gBattleStruct->speedTieBreaks = RandomUniform(RNG_SPEED_TIE, 0, Factorial(MAX_BATTLERS_COUNT) - 1);
 
@@ -3741,6 +3744,9 @@ void BattleTurnPassed(void)
     for (i = 0; i < 5; i++)
         gBattleCommunication[i] = 0;
 
+    if (gTestRunnerEnabled)
+        TestRunner_Battle_CheckTurnLimit();
+
     if (gBattleOutcome != 0)
     {
         gCurrentActionFuncId = B_ACTION_FINISHED;
@@ -3772,7 +3778,9 @@ void BattleTurnPassed(void)
     BattlePutTextOnWindow(gText_EmptyString3, B_WIN_MSG);
     AssignUsableGimmicks();
     SetShellSideArmCategory();
+    aiBenchmark = TestRunner_Battle_AIBenchmarkStart();
     SetAiLogicDataForTurn(AI_DATA); // get assumed abilities, hold effects, etc of all battlers
+    TestRunner_Battle_AIBenchmarkStop(AI_BENCHMARK_LOGIC_DATA, aiBenchmark);
     gBattleMainFunc = HandleTurnActionSelectionState;
 
     if ((i = ShouldDoTrainerSlide(GetBattlerAtPosition(B_POSITION_OPPONENT_LEFT), TRAINER_SLIDE_LAST_LOW_HP)))
@@ -3953,10 +3961,14 @@ static void HandleTurnActionSelectionState(void)
 
                 // Setup battler data
                 BattleAI_SetupAIData(0xF, battler);
+                u32 aiBenchmark = TestRunner_Battle_AIBenchmarkStart();
                 SetupAISwitchingData(battler, switchType);
+                TestRunner_Battle_AIBenchmarkStop(AI_BENCHMARK_SWITCHING, aiBenchmark);
 
                 // Do scoring
+                aiBenchmark = TestRunner_Battle_AIBenchmarkStart();
                 gBattleStruct->aiMoveOrAction[battler] = BattleAI_ChooseMoveOrAction(battler);
+                TestRunner_Battle_AIBenchmarkStop(AI_BENCHMARK_CHOOSE_MOVE, aiBenchmark);
                 AI_DATA->aiCalcInProgress = FALSE;
             }
             // fallthrough
@@ -5458,15 +5470,39 @@ void RunBattleScriptCommands_PopCallbacksStack(void)
     }
     else
     {
-        if (gBattleControllerExecFlags == 0)
-            gBattleScriptingCommandsTable[gBattlescriptCurrInstr[0]]();
+        ExecuteBattleScriptCommands();
     }
 }
 
 void RunBattleScriptCommands(void)
 {
-    if (gBattleControllerExecFlags == 0)
-        gBattleScriptingCommandsTable[gBattlescriptCurrInstr[0]]();
+    ExecuteBattleScriptCommands();
+}
+
+// Runs up to B_SCRIPT_COMMANDS_PER_FRAME commands. Stops early at the
+// first command which has to wait for a later frame, i.e. one which marks
+// a controller for execution, or which does not advance
+// gBattlescriptCurrInstr (waiting on a counter, a message or a multi-step
+// state, or ending the script), or which changes what runs the script.
+void ExecuteBattleScriptCommands(void)
+{
+    u32 i;
+    const u8 *instr;
+    void (*battleMainFunc)(void) = gBattleMainFunc;
+    u32 actionFuncId = gCurrentActionFuncId;
+
+    for (i = 0; i < B_SCRIPT_COMMANDS_PER_FRAME; i++)
+    {
+        if (gBattleControllerExecFlags != 0)
+            break;
+        instr = gBattlescriptCurrInstr;
+        gBattleScriptingCommandsTable[instr[0]]();
+        if (gBattlescriptCurrInstr == instr
+         || gBattleMainFunc != battleMainFunc
+         || gCurrentActionFuncId != actionFuncId
+         || gBattleOutcome != 0)
+            break;
+    }
 }
 
 bool32 TrySetAteType(u32 move, u32 battlerAtk, u32 attackerAbility)
@@ -8492,8 +8492,7 @@ void ClearVariousBattlerFlags(u32 battler)
 
 void HandleAction_RunBattleScript(void) // identical to RunBattleScriptCommands
 {
-    if (gBattleControllerExecFlags == 0)
-        gBattleScriptingCommandsTable[*gBattlescriptCurrInstr]();
+    ExecuteBattleScriptCommands();
 }
 
 u32 SetRandomTarget(u32 battlerAtk)
@@ -5,13 +5,98 @@
 
 EWRAM_DATA ALIGNED(4) u8 gDecompressionBuffer[0x4000] = {0};
 
+// Copies length bytes, a word at a time where dest and src are aligned
+// alike. Overlapping copies must have src at least 4 bytes before dest.
+static inline __attribute__((always_inline)) void FastLZCopy(u8 *dest, const u8 *src, u32 length)
+{
+    if (length >= 8 && !(((uintptr_t)dest ^ (uintptr_t)src) & 3))
+    {
+        while ((uintptr_t)dest & 3)
+        {
+            *dest++ = *src++;
+            length--;
+        }
+        while (length >= 4)
+        {
+            *(u32 *)dest = *(const u32 *)src;
+            dest += 4;
+            src += 4;
+            length -= 4;
+        }
+    }
+    while (length != 0)
+    {
+        *dest++ = *src++;
+        length--;
+    }
+}
+
+// Decompresses the fast LZ format (see tools/gbagfx/fastlz.c): sequences
+// of a token byte, literals and a 16-bit match offset, all byte-aligned.
+IWRAM_CODE static void FastLZDecompress(const u8 *src, u8 *dest)
+{
+    u8 *end = dest + (src[1] | (src[2] << 8) | (src[3] << 16));
+
+    src += 4;
+    while (dest < end)
+    {
+        u32 token = *src++;
+        u32 length = token >> 4;
+        u32 offset, byte;
+
+        if (length == 15)
+        {
+            do
+            {
+                byte = *src++;
+                length += byte;
+            } while (byte == 255);
+        }
+        FastLZCopy(dest, src, length);
+        src += length;
+        dest += length;
+        if (dest >= end)
+            break;
+
+        offset = src[0] | (src[1] << 8);
+        src += 2;
+        length = (token & 0xF) + 4;
+        if (length == 15 + 4)
+        {
+            do
+            {
+                byte = *src++;
+                length += byte;
+            } while (byte == 255);
+        }
+        if (offset < 4)
+        {
+            // Runs of a repeated byte or pair.
+            for (; length != 0; length--, dest++)
+                *dest = *(dest - offset);
+        }
+        else
+        {
+            FastLZCopy(dest, dest - offset, length);
+            dest += length;
+        }
+    }
+}
+
+// Decompresses either BIOS LZ77 or fast LZ data, by its header.
 void LZDecompressWram(const void *src, void *dest)
 {
-    LZ77UnCompWram(src, dest);
+    if (*(const u8 *)src == FAST_LZ_HEADER)
+        FastLZDecompress(src, dest);
+    else
+        LZ77UnCompWram(src, dest);
 }
 
+// Only BIOS LZ77 data can be decompressed directly to VRAM, which ignores
+// byte writes.
 void LZDecompressVram(const void *src, void *dest)
 {
+    AGB_ASSERT(*(const u8 *)src == LZ77_HEADER);
     LZ77UnCompVram(src, dest);
 }
 
@@ -27,7 +112,7 @@ u32 IsLZ77Data(const void *ptr, u32 minSize, u32 maxSize)
         return 0;
     // Check LZ77 header byte
     // See https://problemkaputt.de/gbatek.htm#biosdecompressionfunctions
-    if (data[0] != 0x10)
+    if (data[0] != LZ77_HEADER)
         return 0;
 
     // Read 24-bit uncompressed size
@@ -37,11 +122,28 @@ u32 IsLZ77Data(const void *ptr, u32 minSize, u32 maxSize)
     return 0;
 }
 
+// Like IsLZ77Data, but for either format LZDecompressWram handles
+u32 IsCompressedData(const void *ptr, u32 minSize, u32 maxSize)
+{
+    const u8 *data = ptr;
+    u32 size;
+
+    if (((u32)ptr) & 3)
+        return 0;
+    if (data[0] != LZ77_HEADER && data[0] != FAST_LZ_HEADER)
+        return 0;
+
+    size = data[1] | (data[2] << 8) | (data[3] << 16);
+    if (size >= minSize && size <= maxSize)
+        return size;
+    return 0;
+}
+
 u16 LoadCompressedSpriteSheet(const struct CompressedSpriteSheet *src)
 {
     struct SpriteSheet dest;
 
-    LZ77UnCompWram(src->data, gDecompressionBuffer);
+    LZDecompressWram(src->data, gDecompressionBuffer);
     dest.data = gDecompressionBuffer;
     dest.size = src->size;
     dest.tag = src->tag;
@@ -55,11 +157,11 @@ u16 LoadCompressedSpriteSheetByTemplate(const struct SpriteTemplate *template, s
     struct SpriteFrameImage myImage;
     u32 size;
 
-    // Check for LZ77 header and read uncompressed size, or fallback if not compressed (zero size)
-    if ((size = IsLZ77Data(template->images->data, TILE_SIZE_4BPP, sizeof(gDecompressionBuffer))) == 0)
+    // Check for a compression header and read uncompressed size, or fallback if not compressed (zero size)
+    if ((size = IsCompressedData(template->images->data, TILE_SIZE_4BPP, sizeof(gDecompressionBuffer))) == 0)
         return LoadSpriteSheetByTemplate(template, 0, offset);
 
-    LZ77UnCompWram(template->images->data, gDecompressionBuffer);
+    LZDecompressWram(template->images->data, gDecompressionBuffer);
     myImage.data = gDecompressionBuffer;
     myImage.size = size + offset;
     myTemplate.images = &myImage;
@@ -72,7 +174,7 @@ void LoadCompressedSpriteSheetOverrideBuffer(const struct CompressedSpriteSheet
 {
     struct SpriteSheet dest;
 
-    LZ77UnCompWram(src->data, buffer);
+    LZDecompressWram(src->data, buffer);
     dest.data = buffer;
     dest.size = src->size;
     dest.tag = src->tag;
@@ -83,7 +185,7 @@ void LoadCompressedSpritePalette(const struct CompressedSpritePalette *src)
 {
     struct SpritePalette dest;
 
-    LZ77UnCompWram(src->data, gDecompressionBuffer);
+    LZDecompressWram(src->data, gDecompressionBuffer);
     dest.data = (void *) gDecompressionBuffer;
     dest.tag = src->tag;
     LoadSpritePalette(&dest);
@@ -93,7 +195,7 @@ void LoadCompressedSpritePaletteWithTag(const u32 *pal, u16 tag)
 {
     struct SpritePalette dest;
 
-    LZ77UnCompWram(pal, gDecompressionBuffer);
+    LZDecompressWram(pal, gDecompressionBuffer);
     dest.data = (void *) gDecompressionBuffer;
     dest.tag = tag;
     LoadSpritePalette(&dest);
@@ -103,7 +205,7 @@ void LoadCompressedSpritePaletteOverrideBuffer(const struct CompressedSpritePale
 {
     struct SpritePalette dest;
 
-    LZ77UnCompWram(src->data, buffer);
+    LZDecompressWram(src->data, buffer);
     dest.data = buffer;
     dest.tag = src->tag;
     LoadSpritePalette(&dest);
@@ -111,7 +213,7 @@ void LoadCompressedSpritePaletteOverrideBuffer(const struct CompressedSpritePale
 
 void DecompressPicFromTable(const struct CompressedSpriteSheet *src, void *buffer)
 {
-    LZ77UnCompWram(src->data, buffer);
+    LZDecompressWram(src->data, buffer);
 }
 
 void HandleLoadSpecialPokePic(bool32 isFrontPic, void *dest, s32 species, u32 personality)
@@ -129,25 +231,25 @@ void LoadSpecialPokePic(void *dest, s32 species, u32 personality, bool8 isFrontP
     {
     #if P_GENDER_DIFFERENCES
         if (gSpeciesInfo[species].frontPicFemale != NULL && IsPersonalityFemale(species, personality))
-            LZ77UnCompWram(gSpeciesInfo[species].frontPicFemale, dest);
+            LZDecompressWram(gSpeciesInfo[species].frontPicFemale, dest);
         else
     #endif
         if (gSpeciesInfo[species].frontPic != NULL)
-            LZ77UnCompWram(gSpeciesInfo[species].frontPic, dest);
+            LZDecompressWram(gSpeciesInfo[species].frontPic, dest);
         else
-            LZ77UnCompWram(gSpeciesInfo[SPECIES_NONE].frontPic, dest);
+            LZDecompressWram(gSpeciesInfo[SPECIES_NONE].frontPic, dest);
     }
     else
     {
     #if P_GENDER_DIFFERENCES
         if (gSpeciesInfo[species].backPicFemale != NULL && IsPersonalityFemale(species, personality))
-            LZ77UnCompWram(gSpeciesInfo[species].backPicFemale, dest);
+            LZDecompressWram(gSpeciesInfo[species].backPicFemale, dest);
         else
     #endif
         if (gSpeciesInfo[species].backPic != NULL)
-            LZ77UnCompWram(gSpeciesInfo[species].backPic, dest);
+            LZDecompressWram(gSpeciesInfo[species].backPic, dest);
         else
-            LZ77UnCompWram(gSpeciesInfo[SPECIES_NONE].backPic, dest);
+            LZDecompressWram(gSpeciesInfo[SPECIES_NONE].backPic, dest);
     }
     DrawSpindaSpots(species, personality, dest, isFrontPic);
 }
@@ -158,7 +260,7 @@ bool8 LoadCompressedSpriteSheetUsingHeap(const struct CompressedSpriteSheet *src
     void *buffer;
 
     buffer = AllocZeroed(src->data[0] >> 8);
-    LZ77UnCompWram(src->data, buffer);
+    LZDecompressWram(src->data, buffer);
 
     dest.data = buffer;
     dest.size = src->size;
@@ -175,7 +277,7 @@ bool8 LoadCompressedSpritePaletteUsingHeap(const struct CompressedSpritePalette
     void *buffer;
 
     buffer = AllocZeroed(src->data[0] >> 8);
-    LZ77UnCompWram(src->data, buffer);
+    LZDecompressWram(src->data, buffer);
     dest.data = buffer;
     dest.tag = src->tag;
 
@@ -192,7 +294,7 @@ bool8 LoadCompressedSpritePaletteUsingHeapWithTag(const u32 *pal, u16 tag)
     buffer = AllocZeroed(*((u32 *)pal) >> 8);
     if (!buffer)
         return TRUE;
-    LZ77UnCompWram(pal, buffer);
+    LZDecompressWram(pal, buffer);
     dest.data = buffer;
     dest.tag = tag;
     LoadSpritePalette(&dest);
@@ -205,3 +307,171 @@ u32 GetDecompressedDataSize(const u32 *ptr)
     const u8 *ptr8 = (const u8 *)ptr;
     return (ptr8[3] << 16) | (ptr8[2] << 8) | (ptr8[1]);
 }
+
+// Asynchronous LZ77 decompression, resumable at any byte so that a large
+// asset can be spread over several frames. Requests are processed in the
+// order they are made.
+#define MAX_ASYNC_DECOMPRESS_REQUESTS 8
+
+struct AsyncDecompressRequest
+{
+    const u8 *src;
+    u8 *dest;
+    AsyncDecompressCallback callback;
+    u32 size;
+    u32 pos;
+    u16 copyLength; // left to copy of the current back reference
+    u16 copyDistance;
+    u8 flags;
+    u8 flagsLeft;
+    bool8 vram;
+    u8 pendingByte; // low byte of the halfword being written to VRAM
+};
+
+static EWRAM_DATA struct AsyncDecompressRequest sAsyncDecompressRequests[MAX_ASYNC_DECOMPRESS_REQUESTS] = {0};
+static EWRAM_DATA u8 sAsyncDecompressHead = 0;
+static EWRAM_DATA u8 sAsyncDecompressCount = 0;
+
+// Decompresses up to maxBytes of the request, and returns how many were.
+// VRAM is written a halfword at a time, as it ignores byte writes.
+IWRAM_CODE static u32 AsyncLZDecompressStep(struct AsyncDecompressRequest *request, u32 maxBytes)
+{
+    const u8 *src = request->src;
+    u8 *dest = request->dest;
+    u32 pos = request->pos;
+    u32 end = request->size - pos < maxBytes ? request->size : pos + maxBytes;
+    u32 copyLength = request->copyLength;
+    u32 flags = request->flags;
+    u32 flagsLeft = request->flagsLeft;
+    u32 pendingByte = request->pendingByte;
+
+    while (pos < end)
+    {
+        u32 value;
+
+        if (copyLength != 0)
+        {
+            u32 from = pos - request->copyDistance;
+            // The byte before an odd position in VRAM has not been written yet.
+            if (request->vram && from == pos - 1 && (pos & 1))
+                value = pendingByte;
+            else
+                value = dest[from];
+            copyLength--;
+        }
+        else
+        {
+            if (flagsLeft == 0)
+            {
+                flags = *src++;
+                flagsLeft = 8;
+            }
+            flagsLeft--;
+            flags <<= 1;
+            if (flags & 0x100)
+            {
+                copyLength = (src[0] >> 4) + 3;
+                request->copyDistance = (((src[0] & 0xF) << 8) | src[1]) + 1;
+                src += 2;
+                continue;
+            }
+            value = *src++;
+        }
+
+        if (!request->vram)
+            dest[pos] = value;
+        else if (!(pos & 1))
+            pendingByte = value;
+        else
+            *(u16 *)&dest[pos - 1] = pendingByte | (value << 8);
+        pos++;
+    }
+
+    // An odd sized request ends with half of a halfword.
+    if (request->vram && pos == request->size && (pos & 1))
+        *(u16 *)&dest[pos - 1] = pendingByte;
+
+    maxBytes = pos - request->pos;
+    request->src = src;
+    request->pos = pos;
+    request->copyLength = copyLength;
+    request->flags = flags;
+    request->flagsLeft = flagsLeft;
+    request->pendingByte = pendingByte;
+    return maxBytes;
+}
+
+static void RequestAsyncLZDecompress(const void *src, void *dest, AsyncDecompressCallback callback, bool32 vram)
+{
+    struct AsyncDecompressRequest *request;
+
+    AGB_ASSERT(*(const u8 *)src == LZ77_HEADER);
+
+    // Rather than fail, wait for the queued requests so that the order
+    // of the writes is kept.
+    if (sAsyncDecompressCount == MAX_ASYNC_DECOMPRESS_REQUESTS)
+        FinishAsyncDecompression();
+
+    request = &sAsyncDecompressRequests[(sAsyncDecompressHead + sAsyncDecompressCount) % MAX_ASYNC_DECOMPRESS_REQUESTS];
+    request->src = (const u8 *)src + 4;
+    request->dest = dest;
+    request->callback = callback;
+    request->size = GetDecompressedDataSize(src);
+    request->pos = 0;
+    request->copyLength = 0;
+    request->copyDistance = 0;
+    request->flags = 0;
+    request->flagsLeft = 0;
+    request->vram = vram;
+    request->pendingByte = 0;
+    sAsyncDecompressCount++;
+}
+
+void RequestAsyncLZDecompressWram(const void *src, void *dest, AsyncDecompressCallback callback)
+{
+    RequestAsyncLZDecompress(src, dest, callback, FALSE);
+}
+
+void RequestAsyncLZDecompressVram(const void *src, void *dest, AsyncDecompressCallback callback)
+{
+    RequestAsyncLZDecompress(src, dest, callback, TRUE);
+}
+
+bool32 IsAsyncDecompressionActive(void)
+{
+    return sAsyncDecompressCount != 0;
+}
+
+// Decompresses up to maxBytes of the queued requests, calling back the
+// ones which finish. Called every frame from the main loop with
+// ASYNC_DECOMPRESS_BYTES_PER_FRAME.
+void RunAsyncDecompression(u32 maxBytes)
+{
+    while (sAsyncDecompressCount != 0 && maxBytes != 0)
+    {
+        struct AsyncDecompressRequest *request = &sAsyncDecompressRequests[sAsyncDecompressHead];
+
+        maxBytes -= AsyncLZDecompressStep(request, maxBytes);
+        if (request->pos != request->size)
+            break;
+
+        sAsyncDecompressHead = (sAsyncDecompressHead + 1) % MAX_ASYNC_DECOMPRESS_REQUESTS;
+        sAsyncDecompressCount--;
+        if (request->callback != NULL)
+            request->callback(request->dest, request->size);
+    }
+}
+
+void FinishAsyncDecompression(void)
+{
+    while (sAsyncDecompressCount != 0)
+        RunAsyncDecompression(UINT32_MAX);
+}
+
+// Drops the queued requests without calling them back, e.g. before
+// freeing their buffers.
+void CancelAsyncDecompression(void)
+{
+    sAsyncDecompressHead = 0;
+    sAsyncDecompressCount = 0;
+}
@@ -2,164 +2,320 @@
 #include "dma3.h"
 
 #define MAX_DMA_REQUESTS 128
+#define MAX_DMA_BYTES_PER_FRAME (40 * 1024)
+#define NO_DMA_REQUEST 0xFF
 
+// Requests are queued per priority class (see Dma3RequestPriority), and
+// each class is processed in order. A request never runs before an
+// earlier one that writes to or reads from the same bytes. A request is merged into an earlier
+// one of its class when they copy the same bytes or fill with the same
+// value and touch or overlap, or when the new one replaces the earlier
+// one's destination exactly, but only if nothing queued between them
+// writes to or reads from either.
 static struct {
     /* 0x00 */ const u8 *src;
     /* 0x04 */ u8 *dest;
     /* 0x08 */ u16 size;
-    /* 0x0A */ u16 mode;
+    /* 0x0A */ u8 mode;
+    /* 0x0B */ u8 next;
     /* 0x0C */ u32 value;
-} gDma3Requests[128];
+} gDma3Requests[MAX_DMA_REQUESTS];
 
 static volatile bool8 gDma3ManagerLocked;
-static u8 gDma3RequestCursor;
+// Zeroed queues are not empty, so nothing is processed until
+// ClearDma3Requests sets them up.
+static bool8 sDma3QueuesReady;
+static u8 sDma3QueueHeads[DMA3_PRIORITY_COUNT];
+static u8 sDma3QueueTails[DMA3_PRIORITY_COUNT];
+static u8 sDma3FreeHead;
+
+#if PROFILE
+static EWRAM_DATA u32 sDma3MergedRequests = 0;
+static EWRAM_DATA u32 sDma3DeferredFrames = 0;
+static EWRAM_DATA u32 sDma3DeferredBytes = 0;
+static EWRAM_DATA u32 sDma3MaxDeferredBytes = 0;
+#endif
 
 void ClearDma3Requests(void)
 {
     int i;
 
     gDma3ManagerLocked = TRUE;
-    gDma3RequestCursor = 0;
 
     for(i = 0; i < (u8)NELEMS(gDma3Requests); i++)
     {
         gDma3Requests[i].size = 0;
         gDma3Requests[i].src = 0;
         gDma3Requests[i].dest = 0;
+        gDma3Requests[i].next = i + 1 < MAX_DMA_REQUESTS ? i + 1 : NO_DMA_REQUEST;
+    }
+    sDma3FreeHead = 0;
+
+    for (i = 0; i < DMA3_PRIORITY_COUNT; i++)
+    {
+        sDma3QueueHeads[i] = NO_DMA_REQUEST;
+        sDma3QueueTails[i] = NO_DMA_REQUEST;
     }
+    sDma3QueuesReady = TRUE;
 
     gDma3ManagerLocked = FALSE;
 }
 
+static bool32 Overlaps(const u8 *a, u32 aSize, const u8 *b, u32 bSize)
+{
+    return a < b + bSize && b < a + aSize;
+}
+
+static bool32 IsFill(u32 mode)
+{
+    return mode == DMA_REQUEST_FILL32 || mode == DMA_REQUEST_FILL16;
+}
+
+static void ProcessDma3Request(u32 index)
+{
+    switch (gDma3Requests[index].mode)
+    {
+    case DMA_REQUEST_COPY32: // regular 32-bit copy
+        Dma3CopyLarge32_(gDma3Requests[index].src,
+                         gDma3Requests[index].dest,
+                         gDma3Requests[index].size);
+        break;
+    case DMA_REQUEST_FILL32: // repeat a single 32-bit value across RAM
+        Dma3FillLarge32_(gDma3Requests[index].value,
+                         gDma3Requests[index].dest,
+                         gDma3Requests[index].size);
+        break;
+    case DMA_REQUEST_COPY16:    // regular 16-bit copy
+        Dma3CopyLarge16_(gDma3Requests[index].src,
+                         gDma3Requests[index].dest,
+                         gDma3Requests[index].size);
+        break;
+    case DMA_REQUEST_FILL16: // repeat a single 16-bit value across RAM
+        Dma3FillLarge16_(gDma3Requests[index].value,
+                         gDma3Requests[index].dest,
+                         gDma3Requests[index].size);
+        break;
+    }
+}
+
 void ProcessDma3Requests(void)
 {
-    u16 bytesTransferred;
+    u32 priority;
+    u32 bytesTransferred;
 
-    if (gDma3ManagerLocked)
+    if (gDma3ManagerLocked || !sDma3QueuesReady)
         return;
 
     bytesTransferred = 0;
 
     // as long as there are DMA requests to process (unless size or vblank is an issue), do not exit
-    while (gDma3Requests[gDma3RequestCursor].size != 0)
+    for (priority = 0; priority < DMA3_PRIORITY_COUNT; priority++)
     {
-        bytesTransferred += gDma3Requests[gDma3RequestCursor].size;
+        u32 index;
+        while ((index = sDma3QueueHeads[priority]) != NO_DMA_REQUEST)
+        {
+            bytesTransferred += gDma3Requests[index].size;
 
-        if (bytesTransferred > 40 * 1024)
-            return; // don't transfer more than 40 KiB
-        if (*(u8 *)REG_ADDR_VCOUNT > 224)
-            return; // we're about to leave vblank, stop
+            // don't transfer more than 40 KiB, unless it is all one request
+            if (bytesTransferred > MAX_DMA_BYTES_PER_FRAME && bytesTransferred != gDma3Requests[index].size)
+                goto deferred;
+            if (*(u8 *)REG_ADDR_VCOUNT > 224)
+                goto deferred; // we're about to leave vblank, stop
 
-        switch (gDma3Requests[gDma3RequestCursor].mode)
+            ProcessDma3Request(index);
+
+            // Free the request
+            sDma3QueueHeads[priority] = gDma3Requests[index].next;
+            if (sDma3QueueHeads[priority] == NO_DMA_REQUEST)
+                sDma3QueueTails[priority] = NO_DMA_REQUEST;
+            gDma3Requests[index].src = NULL;
+            gDma3Requests[index].dest = NULL;
+            gDma3Requests[index].size = 0;
+            gDma3Requests[index].mode = 0;
+            gDma3Requests[index].value = 0;
+            gDma3Requests[index].next = sDma3FreeHead;
+            sDma3FreeHead = index;
+        }
+    }
+    return;
+
+deferred:
+#if PROFILE
+    {
+        u32 index, deferredBytes = 0;
+        for (; priority < DMA3_PRIORITY_COUNT; priority++)
         {
-        case DMA_REQUEST_COPY32: // regular 32-bit copy
-            Dma3CopyLarge32_(gDma3Requests[gDma3RequestCursor].src,
-                             gDma3Requests[gDma3RequestCursor].dest,
-                             gDma3Requests[gDma3RequestCursor].size);
-            break;
-        case DMA_REQUEST_FILL32: // repeat a single 32-bit value across RAM
-            Dma3FillLarge32_(gDma3Requests[gDma3RequestCursor].value,
-                             gDma3Requests[gDma3RequestCursor].dest,
-                             gDma3Requests[gDma3RequestCursor].size);
-            break;
-        case DMA_REQUEST_COPY16:    // regular 16-bit copy
-            Dma3CopyLarge16_(gDma3Requests[gDma3RequestCursor].src,
-                             gDma3Requests[gDma3RequestCursor].dest,
-                             gDma3Requests[gDma3RequestCursor].size);
-            break;
-        case DMA_REQUEST_FILL16: // repeat a single 16-bit value across RAM
-            Dma3FillLarge16_(gDma3Requests[gDma3RequestCursor].value,
-                             gDma3Requests[gDma3RequestCursor].dest,
-                             gDma3Requests[gDma3RequestCursor].size);
-            break;
+            for (index = sDma3QueueHeads[priority]; index != NO_DMA_REQUEST; index = gDma3Requests[index].next)
+                deferredBytes += gDma3Requests[index].size;
         }
+        sDma3DeferredFrames++;
+        sDma3DeferredBytes += deferredBytes;
+        if (sDma3MaxDeferredBytes < deferredBytes)
+            sDma3MaxDeferredBytes = deferredBytes;
+    }
+#endif
+    return;
+}
 
-        // Free the request
-        gDma3Requests[gDma3RequestCursor].src = NULL;
-        gDma3Requests[gDma3RequestCursor].dest = NULL;
-        gDma3Requests[gDma3RequestCursor].size = 0;
-        gDma3Requests[gDma3RequestCursor].mode = 0;
-        gDma3Requests[gDma3RequestCursor].value = 0;
-        gDma3RequestCursor++;
+// Returns TRUE if the request and a new one write to or read from the
+// same bytes, so they must run in the order they were queued.
+static bool32 Dma3RequestsConflict(u32 index, const u8 *src, u8 *dest, u32 size, u32 mode)
+{
+    const u8 *requestSrc = gDma3Requests[index].src;
+    u8 *requestDest = gDma3Requests[index].dest;
+    u32 requestSize = gDma3Requests[index].size;
 
-        if (gDma3RequestCursor >= MAX_DMA_REQUESTS) // loop back to the first DMA request
-            gDma3RequestCursor = 0;
-    }
+    return Overlaps(requestDest, requestSize, dest, size)
+        || (!IsFill(mode) && Overlaps(requestDest, requestSize, src, size))
+        || (!IsFill(gDma3Requests[index].mode) && Overlaps(requestSrc, requestSize, dest, size));
 }
 
-s16 RequestDma3Copy(const void *src, void *dest, u16 size, u8 mode)
+// Palettes and OAM first, so that they are not starved by tiles, which
+// is most of what is streamed to VRAM.
+static u32 Dma3DestPriority(const void *dest)
 {
-    int cursor;
-    int var = 0;
+    uintptr_t address = (uintptr_t)dest;
+    if ((address >= PLTT && address < PLTT + PLTT_SIZE)
+     || (address >= OAM && address < OAM + OAM_SIZE))
+        return DMA3_PRIORITY_HIGH;
+    else if (address >= VRAM && address < VRAM + VRAM_SIZE)
+        return DMA3_PRIORITY_LOW;
+    else
+        return DMA3_PRIORITY_NORMAL;
+}
 
-    gDma3ManagerLocked = 1;
+// The priority of dest, lowered to that of any later-processed request
+// which the new one conflicts with, so that it still runs after it.
+static u32 Dma3RequestPriority(const u8 *src, u8 *dest, u32 size, u32 mode)
+{
+    u32 index, later;
+    u32 priority = Dma3DestPriority(dest);
 
-    cursor = gDma3RequestCursor;
-    while(1)
+    for (later = priority + 1; later < DMA3_PRIORITY_COUNT; later++)
     {
-        if(!gDma3Requests[cursor].size) // an empty copy was found and the current cursor will be returned.
+        for (index = sDma3QueueHeads[later]; index != NO_DMA_REQUEST; index = gDma3Requests[index].next)
         {
-            gDma3Requests[cursor].src = src;
-            gDma3Requests[cursor].dest = dest;
-            gDma3Requests[cursor].size = size;
+            if (Dma3RequestsConflict(index, src, dest, size, mode))
+            {
+                priority = later;
+                break;
+            }
+        }
+    }
 
-            if(mode == DMA3_32BIT)
-                gDma3Requests[cursor].mode = DMA_REQUEST_COPY32;
-            else
-                gDma3Requests[cursor].mode = DMA_REQUEST_COPY16;
+    return priority;
+}
 
-            gDma3ManagerLocked = FALSE;
-            return (s16)cursor;
-        }
-        if(++cursor >= 0x80) // loop back to start.
+// Returns the request which the new one can be merged into, or
+// NO_DMA_REQUEST.
+static u32 FindMergeableDma3Request(u32 priority, const u8 *src, u8 *dest, u32 size, u32 mode, u32 value)
+{
+    u32 index;
+    u32 merge = NO_DMA_REQUEST;
+
+    for (index = sDma3QueueHeads[priority]; index != NO_DMA_REQUEST; index = gDma3Requests[index].next)
+    {
+        const u8 *requestSrc = gDma3Requests[index].src;
+        u8 *requestDest = gDma3Requests[index].dest;
+        u32 requestSize = gDma3Requests[index].size;
+        bool32 touches = requestDest <= dest + size && dest <= requestDest + requestSize;
+
+        if (gDma3Requests[index].mode == mode
+         && ((requestDest == dest && requestSize == size)
+          || (touches && (IsFill(mode) ? gDma3Requests[index].value == value
+                                      : requestSrc - requestDest == src - dest))))
         {
-            cursor = 0;
+            merge = index;
         }
-        if(++var >= 0x80) // max checks were made. all resulted in failure.
+        else if (Dma3RequestsConflict(index, src, dest, size, mode))
         {
-            break;
+            merge = NO_DMA_REQUEST;
         }
     }
-    gDma3ManagerLocked = FALSE;
-    return -1;
+
+    return merge;
 }
 
-s16 RequestDma3Fill(s32 value, void *dest, u16 size, u8 mode)
+static s16 RequestDma3(const void *src, void *dest, u16 size, u32 mode, u32 value)
 {
-    int cursor;
-    int var = 0;
+    u32 index, priority;
+    u8 *start, *end;
 
-    cursor = gDma3RequestCursor;
-    gDma3ManagerLocked = 1;
+    if (!sDma3QueuesReady)
+        ClearDma3Requests();
 
-    while(1)
+    gDma3ManagerLocked = TRUE;
+
+    priority = Dma3RequestPriority(src, dest, size, mode);
+    index = FindMergeableDma3Request(priority, src, dest, size, mode, value);
+    if (index != NO_DMA_REQUEST)
     {
-        if(!gDma3Requests[cursor].size)
+        start = min(gDma3Requests[index].dest, (u8 *)dest);
+        end = max(gDma3Requests[index].dest + gDma3Requests[index].size, (u8 *)dest + size);
+        if (gDma3Requests[index].dest == dest && gDma3Requests[index].size == size)
         {
-            gDma3Requests[cursor].dest = dest;
-            gDma3Requests[cursor].size = size;
-            gDma3Requests[cursor].mode = mode;
-            gDma3Requests[cursor].value = value;
-
-            if(mode == DMA3_32BIT)
-                gDma3Requests[cursor].mode = DMA_REQUEST_FILL32;
-            else
-                gDma3Requests[cursor].mode = DMA_REQUEST_FILL16;
-
-            gDma3ManagerLocked = FALSE;
-            return (s16)cursor;
+            // The new request replaces the old one.
+            gDma3Requests[index].src = src;
+            gDma3Requests[index].value = value;
         }
-        if(++cursor >= 0x80) // loop back to start.
+        else if (end - start <= 0xFFFF)
         {
-            cursor = 0;
+            if (!IsFill(mode))
+                gDma3Requests[index].src += start - gDma3Requests[index].dest;
+            gDma3Requests[index].dest = start;
+            gDma3Requests[index].size = end - start;
         }
-        if(++var >= 0x80) // max checks were made. all resulted in failure.
+        else
         {
-            break;
+            index = NO_DMA_REQUEST;
         }
+
+#if PROFILE
+        if (index != NO_DMA_REQUEST)
+            sDma3MergedRequests++;
+#endif
+    }
+
+    if (index == NO_DMA_REQUEST && sDma3FreeHead != NO_DMA_REQUEST)
+    {
+        index = sDma3FreeHead;
+        sDma3FreeHead = gDma3Requests[index].next;
+
+        gDma3Requests[index].src = src;
+        gDma3Requests[index].dest = dest;
+        gDma3Requests[index].size = size;
+        gDma3Requests[index].mode = mode;
+        gDma3Requests[index].value = value;
+        gDma3Requests[index].next = NO_DMA_REQUEST;
+
+        if (sDma3QueueTails[priority] == NO_DMA_REQUEST)
+            sDma3QueueHeads[priority] = index;
+        else
+            gDma3Requests[sDma3QueueTails[priority]].next = index;
+        sDma3QueueTails[priority] = index;
     }
+
     gDma3ManagerLocked = FALSE;
-    return -1;
+
+    if (index == NO_DMA_REQUEST)
+        return -1;
+    return (s16)index;
+}
+
+s16 RequestDma3Copy(const void *src, void *dest, u16 size, u8 mode)
+{
+    if(mode == DMA3_32BIT)
+        return RequestDma3(src, dest, size, DMA_REQUEST_COPY32, 0);
+    else
+        return RequestDma3(src, dest, size, DMA_REQUEST_COPY16, 0);
+}
+
+s16 RequestDma3Fill(s32 value, void *dest, u16 size, u8 mode)
+{
+    if(mode == DMA3_32BIT)
+        return RequestDma3(NULL, dest, size, DMA_REQUEST_FILL32, value);
+    else
+        return RequestDma3(NULL, dest, size, DMA_REQUEST_FILL16, value);
 }
 
 s16 WaitDma3Request(s16 index)
@@ -168,7 +324,7 @@ s16 WaitDma3Request(s16 index)
 
     if (index == -1)
     {
-        for (; current < 0x80; current ++)
+        for (; current < MAX_DMA_REQUESTS; current ++)
             if (gDma3Requests[current].size)
                 return -1;
 
@@ -180,3 +336,15 @@ s16 WaitDma3Request(s16 index)
 
     return 0;
 }
+
+#if PROFILE
+void PrintDma3Stats(void)
+{
+    DebugPrintf("DMA3: %u requests merged, %u frames deferred requests, %u bytes deferred, at most %u in a frame",
+                sDma3MergedRequests, sDma3DeferredFrames, sDma3DeferredBytes, sDma3MaxDeferredBytes);
+    sDma3MergedRequests = 0;
+    sDma3DeferredFrames = 0;
+    sDma3DeferredBytes = 0;
+    sDma3MaxDeferredBytes = 0;
+}
+#endif
@@ -196,7 +196,8 @@ ALIGNED(4) const u8 gFontNormalCopy1LatinGlyphWidths[] =
 ALIGNED(4) const u16 gFontTallJapaneseGlyphs[] = INCBIN_U16("graphics/fonts/japanese_tall.fwjpnfont");
 
 ALIGNED(4) const u16 gFontNormalLatinGlyphs[] = INCBIN_U16("graphics/fonts/latin_normal.latfont");
-ALIGNED(4) const u8 gFontNormalLatinGlyphWidths[] =
+// Read for every character that is printed or measured.
+ALIGNED(4) IWRAM_RODATA const u8 gFontNormalLatinGlyphWidths[] =
 {
      6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
      6,  6,  8,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
@@ -228,5 +228,6 @@ void FillWindowTilesByRow(int windowId, int columnStart, int rowStart, int numFi
             CpuFastFill8(0x11, windowTileData, fillSize);
             windowTileData += windowRowSize;
         }
+        MarkWindowDirty(windowId, columnStart * TILE_WIDTH, rowStart * TILE_HEIGHT, numFillTiles * TILE_WIDTH, numRows * TILE_HEIGHT);
     }
 }
@@ -1,5 +1,6 @@
 #include "global.h"
 #include "crt0.h"
+#include "decompress.h"
 #include "malloc.h"
 #include "help_system.h"
 #include "link.h"
@@ -25,6 +26,7 @@
 #include "text.h"
 #include "intro.h"
 #include "main.h"
+#include "profile.h"
 #include "trainer_tower.h"
 #include "test_runner.h"
 #include "constants/rgb.h"
@@ -76,6 +78,9 @@ COMMON_DATA s8 gPcmDmaCounter = 0;
 COMMON_DATA void *gAgbMainLoop_sp = NULL;
 
 static EWRAM_DATA u16 sTrainerId = 0;
+#if TESTING
+static EWRAM_DATA bool8 sInSyntheticVBlank = FALSE;
+#endif
 
 static void UpdateLinkAndCallCallbacks(void);
 static void InitMainCallbacks(void);
@@ -139,6 +144,8 @@ void AgbMainLoop(void)
 {
     for (;;)
     {
+        u32 frame = Profile_Begin();
+
         ReadKeys();
 
         if (gSoftResetDisabled == FALSE
@@ -173,6 +180,9 @@ void AgbMainLoop(void)
 
         PlayTimeCounter_Update();
         MapMusicMain();
+        RunAsyncDecompression(ASYNC_DECOMPRESS_BYTES_PER_FRAME);
+        Profile_End(PROFILE_FRAME, NULL, frame);
+        Profile_EndFrame();
         WaitForVBlank();
     }
 }
@@ -206,15 +216,26 @@ static void CallCallbacks(void)
 #endif
     {
         if (gMain.callback1)
-            gMain.callback1();
+        {
+            MainCallback callback = gMain.callback1;
+            u32 profile = Profile_Begin();
+            callback();
+            Profile_End(PROFILE_CALLBACK1, callback, profile);
+        }
 
         if (gMain.callback2)
-            gMain.callback2();
+        {
+            MainCallback callback = gMain.callback2;
+            u32 profile = Profile_Begin();
+            callback();
+            Profile_End(PROFILE_CALLBACK2, callback, profile);
+        }
     }
 }
 
 void SetMainCallback2(MainCallback callback)
 {
+    HeapStats_SampleFragmentation(callback);
     gMain.callback2 = callback;
     gMain.state = 0;
 }
@@ -370,6 +391,21 @@ void SetSerialCallback(IntrCallback callback)
 
 static void VBlankIntr(void)
 {
+    u32 profile;
+
+#if TESTING
+    // Headless tests run the v-blank work from WaitForVBlank as soon as
+    // the frame's work is done, so the hardware v-blank only needs to be
+    // acknowledged (for VBlankIntrWait in BenchmarkStart).
+    if (gTestRunnerHeadless && !sInSyntheticVBlank)
+    {
+        INTR_CHECK |= INTR_FLAG_VBLANK;
+        return;
+    }
+#endif
+
+    profile = Profile_BeginInterrupt();
+
     if (gWirelessCommType != 0)
         RfuVSync();
     else if (gLinkVSyncDisabled == FALSE)
@@ -398,6 +434,8 @@ static void VBlankIntr(void)
 
     UpdateWirelessStatusIndicatorSprite();
 
+    Profile_EndInterrupt(PROFILE_VBLANK, gMain.vblankCallback, profile);
+
     INTR_CHECK |= INTR_FLAG_VBLANK;
     gMain.intrCheck |= INTR_FLAG_VBLANK;
 }
@@ -442,6 +480,21 @@ static void WaitForVBlank(void)
 {
     gMain.intrCheck &= ~INTR_FLAG_VBLANK;
 
+#if TESTING
+    // Nothing is displayed in headless tests, so rather than idling until
+    // the next v-blank (most of a frame's cycles) run its work immediately.
+    if (gTestRunnerHeadless)
+    {
+        u16 imeBak = REG_IME;
+        REG_IME = 0;
+        sInSyntheticVBlank = TRUE;
+        VBlankIntr();
+        sInSyntheticVBlank = FALSE;
+        REG_IME = imeBak;
+        return;
+    }
+#endif
+
     if (gWirelessCommType != 0)
     {
         // Desynchronization may occur if wireless adapter is connected
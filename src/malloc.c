@@ -9,11 +9,190 @@ static u32 sHeapSize;
 
 ALIGNED(4) EWRAM_DATA u8 gHeap[HEAP_SIZE] = {0};
 
+static const char *BlockLocation(const struct MemBlock *block)
+{
+    return (const char *)(ROM_START | (block->locationHi << 14) | block->locationLo);
+}
+
+#if PROFILE
+
+#define HEAP_STATS_SITES_COUNT 128
+#define HEAP_STATS_SAMPLES_COUNT 8
+
+// Sizes are the allocated blocks' sizes, i.e. rounded up to a multiple of
+// 4, and do not include the headers.
+struct HeapSiteStats
+{
+    const char *location;
+    u32 liveBytes;
+    u32 peakBytes;
+    u32 allocs;
+    u32 failures;
+};
+
+struct HeapFragmentationSample
+{
+    void (*callback)(void);
+    u32 largestFree;
+    u32 totalFree;
+};
+
+static EWRAM_DATA struct HeapSiteStats sHeapSiteStats[HEAP_STATS_SITES_COUNT] = {0};
+static EWRAM_DATA struct HeapFragmentationSample sHeapSamples[HEAP_STATS_SAMPLES_COUNT] = {0};
+static EWRAM_DATA struct HeapFragmentationSample sWorstHeapSample = {0};
+static EWRAM_DATA u32 sHeapSamplesCount = 0;
+static EWRAM_DATA u32 sHeapLiveBytes = 0;
+static EWRAM_DATA u32 sHeapPeakBytes = 0;
+static EWRAM_DATA u16 sHeapDroppedSites = 0;
+
+static struct HeapSiteStats *GetHeapSiteStats(const char *location)
+{
+    u32 n, i = ((uintptr_t)location >> 2) % HEAP_STATS_SITES_COUNT;
+    for (n = 0; n < HEAP_STATS_SITES_COUNT; n++, i = (i + 1) % HEAP_STATS_SITES_COUNT)
+    {
+        if (sHeapSiteStats[i].location == location)
+            return &sHeapSiteStats[i];
+        if (sHeapSiteStats[i].location == NULL)
+        {
+            sHeapSiteStats[i].location = location;
+            return &sHeapSiteStats[i];
+        }
+    }
+    sHeapDroppedSites++;
+    return NULL;
+}
+
+static void RecordHeapAlloc(const struct MemBlock *block)
+{
+    struct HeapSiteStats *site = GetHeapSiteStats(BlockLocation(block));
+
+    sHeapLiveBytes += block->size;
+    if (sHeapPeakBytes < sHeapLiveBytes)
+        sHeapPeakBytes = sHeapLiveBytes;
+    if (site != NULL)
+    {
+        site->allocs++;
+        site->liveBytes += block->size;
+        if (site->peakBytes < site->liveBytes)
+            site->peakBytes = site->liveBytes;
+    }
+}
+
+static void RecordHeapFree(const struct MemBlock *block)
+{
+    struct HeapSiteStats *site = GetHeapSiteStats(BlockLocation(block));
+
+    sHeapLiveBytes -= block->size;
+    if (site != NULL)
+        site->liveBytes -= block->size;
+}
+
+static void RecordHeapFailure(const char *location)
+{
+    // Keyed the same as the blocks, which only keep the low bits.
+    struct HeapSiteStats *site = GetHeapSiteStats((const char *)(ROM_START | ((uintptr_t)location & 0x1FFFFFF)));
+
+    if (site != NULL)
+        site->failures++;
+}
+
+// The heap is discarded without freeing its blocks.
+static void ResetHeapLiveBytes(void)
+{
+    u32 i;
+    for (i = 0; i < HEAP_STATS_SITES_COUNT; i++)
+        sHeapSiteStats[i].liveBytes = 0;
+    sHeapLiveBytes = 0;
+}
+
+#else
+
+#define RecordHeapAlloc(block) (void)0
+#define RecordHeapFree(block) (void)0
+#define RecordHeapFailure(location) (void)0
+#define ResetHeapLiveBytes() (void)0
+
+#endif // PROFILE
+
+// Free blocks are also kept in a list per size class, linked through their
+// data, so that allocating does not have to walk past the allocated blocks.
+// A class holds the sizes from 1 << n up to (1 << (n + 1)) - 1, and
+// sFreeBinsMask has bit n set if class n has any blocks.
+#define FREE_BINS_COUNT 18
+#define MIN_BLOCK_SIZE sizeof(struct FreeMemBlockLinks)
+
+struct FreeMemBlockLinks
+{
+    struct MemBlock *prev;
+    struct MemBlock *next;
+};
+
+static struct MemBlock *sFreeBins[FREE_BINS_COUNT];
+static u32 sFreeBinsMask;
+static u32 sHeapArena;
+
+static inline struct FreeMemBlockLinks *FreeLinks(struct MemBlock *block)
+{
+    return (struct FreeMemBlockLinks *)block->data;
+}
+
+static inline u32 FreeBin(u32 size)
+{
+    return 31 - __builtin_clz(size);
+}
+
+static void InsertFreeBlock(struct MemBlock *block)
+{
+    u32 bin = FreeBin(block->size);
+
+    FreeLinks(block)->prev = NULL;
+    FreeLinks(block)->next = sFreeBins[bin];
+    if (sFreeBins[bin] != NULL)
+        FreeLinks(sFreeBins[bin])->prev = block;
+    sFreeBins[bin] = block;
+    sFreeBinsMask |= 1 << bin;
+}
+
+static void RemoveFreeBlock(struct MemBlock *block)
+{
+    u32 bin = FreeBin(block->size);
+    struct FreeMemBlockLinks *links = FreeLinks(block);
+
+    if (links->prev != NULL)
+        FreeLinks(links->prev)->next = links->next;
+    else
+        sFreeBins[bin] = links->next;
+    if (links->next != NULL)
+        FreeLinks(links->next)->prev = links->prev;
+    if (sFreeBins[bin] == NULL)
+        sFreeBinsMask &= ~(1 << bin);
+}
+
+static struct MemBlock *FindFreeBlock(u32 size)
+{
+    u32 bin = FreeBin(size);
+    u32 largerBins;
+    struct MemBlock *block;
+
+    // Only the blocks in the size's own class can be too small.
+    for (block = sFreeBins[bin]; block != NULL; block = FreeLinks(block)->next)
+    {
+        if (block->size >= size)
+            return block;
+    }
+
+    largerBins = sFreeBinsMask & ~((2 << bin) - 1);
+    if (largerBins == 0)
+        return NULL;
+    return sFreeBins[__builtin_ctz(largerBins)];
+}
+
 void PutMemBlockHeader(void *block, struct MemBlock *prev, struct MemBlock *next, u32 size)
 {
     struct MemBlock *header = (struct MemBlock *)block;
 
     header->allocated = FALSE;
+    header->arena = 0;
     header->locationHi = 0;
     header->magic = MALLOC_SYSTEM_ID;
     header->size = size;
@@ -29,84 +208,79 @@ void PutFirstMemBlockHeader(void *block, u32 size)
 
 void *AllocInternal(void *heapStart, u32 size, const char *location)
 {
-    struct MemBlock *pos = (struct MemBlock *)heapStart;
-    struct MemBlock *head = pos;
+    struct MemBlock *head = (struct MemBlock *)heapStart;
+    struct MemBlock *pos;
     struct MemBlock *splitBlock;
     u32 foundBlockSize;
 
-    // Alignment
+    // Alignment, and room for the links once the block is freed.
     if (size & 3)
         size = 4 * ((size / 4) + 1);
+    if (size < MIN_BLOCK_SIZE)
+        size = MIN_BLOCK_SIZE;
 
-    for (;;)
+    pos = FindFreeBlock(size);
+    if (pos == NULL)
     {
-        // Loop through the blocks looking for unused block that's big enough.
-
-        if (!pos->allocated)
+        RecordHeapFailure(location);
+#if TESTING
+        const struct MemBlock *block = head;
+        do
         {
-            foundBlockSize = pos->size;
-
-            if (foundBlockSize >= size)
+            if (block->allocated)
             {
-                if (foundBlockSize - size < 2 * sizeof(struct MemBlock))
-                {
-                    // The block isn't much bigger than the requested size,
-                    // so just use it.
-                    pos->allocated = TRUE;
-                }
+                const char *location = MemBlockLocation(block);
+                if (location)
+                    Test_MgbaPrintf("%s: %d bytes allocated", location, block->size);
                 else
-                {
-                    // The block is significantly bigger than the requested
-                    // size, so split the rest into a separate block.
-                    foundBlockSize -= sizeof(struct MemBlock);
-                    foundBlockSize -= size;
-
-                    splitBlock = (struct MemBlock *)(pos->data + size);
+                    Test_MgbaPrintf("<unknown>: %d bytes allocated", block->size);
+            }
+            block = block->next;
+        }
+        while (block != head);
+        Test_ExitWithResult(TEST_RESULT_ERROR, SourceLine(0), ":L%s:%d, %s: OOM allocating %d bytes", gTestRunnerState.test->filename, SourceLine(0), location, size);
+#endif
+        AGB_ASSERT_EX(0, ABSPATH("gflib/malloc.c"), 174);
+        return NULL;
+    }
 
-                    pos->allocated = TRUE;
-                    pos->size = size;
+    RemoveFreeBlock(pos);
+    foundBlockSize = pos->size;
 
-                    PutMemBlockHeader(splitBlock, pos, pos->next, foundBlockSize);
+    if (foundBlockSize - size < 2 * sizeof(struct MemBlock))
+    {
+        // The block isn't much bigger than the requested size,
+        // so just use it.
+        pos->allocated = TRUE;
+    }
+    else
+    {
+        // The block is significantly bigger than the requested
+        // size, so split the rest into a separate block.
+        foundBlockSize -= sizeof(struct MemBlock);
+        foundBlockSize -= size;
 
-                    pos->next = splitBlock;
+        splitBlock = (struct MemBlock *)(pos->data + size);
 
-                    if (splitBlock->next != head)
-                        splitBlock->next->prev = splitBlock;
-                }
+        pos->allocated = TRUE;
+        pos->size = size;
 
-                pos->locationHi = ((uintptr_t)location) >> 14;
-                pos->locationLo = (uintptr_t)location;
+        PutMemBlockHeader(splitBlock, pos, pos->next, foundBlockSize);
 
-                return pos->data;
-            }
-        }
+        pos->next = splitBlock;
 
-        if (pos->next == head)
-        {
-#if TESTING
-            const struct MemBlock *head = HeapHead();
-            const struct MemBlock *block = head;
-            do
-            {
-                if (block->allocated)
-                {
-                    const char *location = MemBlockLocation(block);
-                    if (location)
-                        Test_MgbaPrintf("%s: %d bytes allocated", location, block->size);
-                    else
-                        Test_MgbaPrintf("<unknown>: %d bytes allocated", block->size);
-                }
-                block = block->next;
-            }
-            while (block != head);
-            Test_ExitWithResult(TEST_RESULT_ERROR, SourceLine(0), ":L%s:%d, %s: OOM allocating %d bytes", gTestRunnerState.test->filename, SourceLine(0), location, size);
-#endif
-            AGB_ASSERT_EX(0, ABSPATH("gflib/malloc.c"), 174);
-            return NULL;
-        }
+        if (splitBlock->next != head)
+            splitBlock->next->prev = splitBlock;
 
-        pos = pos->next;
+        InsertFreeBlock(splitBlock);
     }
+
+    pos->arena = sHeapArena;
+    pos->locationHi = ((uintptr_t)location) >> 14;
+    pos->locationLo = (uintptr_t)location;
+
+    RecordHeapAlloc(pos);
+    return pos->data;
 }
 
 void FreeInternal(void *heapStart, void *pointer)
@@ -119,7 +293,9 @@ void FreeInternal(void *heapStart, void *pointer)
         struct MemBlock *block = (struct MemBlock *)((u8 *)pointer - sizeof(struct MemBlock));
         AGB_ASSERT_EX(block->magic == MALLOC_SYSTEM_ID, ABSPATH("gflib/malloc.c"), 204);
         AGB_ASSERT_EX(block->allocated == TRUE, ABSPATH("gflib/malloc.c"), 205);
+        RecordHeapFree(block);
         block->allocated = FALSE;
+        block->arena = 0;
 
         // If the freed block isn't the last one, merge with the next block
         // if it's not in use.
@@ -127,6 +303,7 @@ void FreeInternal(void *heapStart, void *pointer)
         {
             if (!block->next->allocated)
             {
+                RemoveFreeBlock(block->next);
                 block->size += sizeof(struct MemBlock) + block->next->size;
                 block->next->magic = 0;
                 block->next = block->next->next;
@@ -143,6 +320,7 @@ void FreeInternal(void *heapStart, void *pointer)
             {
                 AGB_ASSERT_EX(block->prev->magic == MALLOC_SYSTEM_ID, ABSPATH("gflib/malloc.c"), 228);
 
+                RemoveFreeBlock(block->prev);
                 block->prev->next = block->next;
 
                 if (block->next != head)
@@ -150,8 +328,11 @@ void FreeInternal(void *heapStart, void *pointer)
 
                 block->magic = 0;
                 block->prev->size += sizeof(struct MemBlock) + block->size;
+                block = block->prev;
             }
         }
+
+        InsertFreeBlock(block);
     }
 }
 
@@ -201,6 +382,11 @@ void InitHeap(void *heapStart, u32 heapSize)
     sHeapStart = heapStart;
     sHeapSize = heapSize;
     PutFirstMemBlockHeader(heapStart, heapSize);
+    memset(sFreeBins, 0, sizeof(sFreeBins));
+    sFreeBinsMask = 0;
+    sHeapArena = 0;
+    InsertFreeBlock(heapStart);
+    ResetHeapLiveBytes();
 }
 
 void *Alloc_(u32 size, const char *location)
@@ -218,6 +404,41 @@ void Free(void *pointer)
     FreeInternal(sHeapStart, pointer);
 }
 
+// Allocations made from now until the matching FreeHeapArena are freed by
+// it, e.g. everything a scene allocates between entering and leaving it.
+// Arenas nest up to MAX_HEAP_ARENAS deep.
+u32 PushHeapArena(void)
+{
+    AGB_ASSERT(sHeapArena < MAX_HEAP_ARENAS);
+    return ++sHeapArena;
+}
+
+// Frees every block allocated since PushHeapArena returned arena,
+// including those of the arenas pushed after it, and goes back to the
+// arena that was current before.
+void FreeHeapArena(u32 arena)
+{
+    struct MemBlock *head = (struct MemBlock *)sHeapStart;
+    struct MemBlock *block = head;
+    struct MemBlock *next;
+
+    AGB_ASSERT(arena != 0 && arena <= sHeapArena);
+    do
+    {
+        next = block->next;
+        if (block->allocated && block->arena >= arena)
+        {
+            // Freeing merges a free next block into this one.
+            if (next != head && !next->allocated)
+                next = next->next;
+            FreeInternal(sHeapStart, block->data);
+        }
+        block = next;
+    } while (block != head);
+
+    sHeapArena = arena - 1;
+}
+
 bool32 CheckMemBlock(void *pointer)
 {
     return CheckMemBlockInternal(sHeapStart, pointer);
@@ -246,5 +467,104 @@ const char *MemBlockLocation(const struct MemBlock *block)
     if (!block->allocated)
         return NULL;
 
-    return (const char *)(ROM_START | (block->locationHi << 14) | block->locationLo);
+    return BlockLocation(block);
+}
+
+static const char *LocationName(const char *location)
+{
+    return location == (const char *)ROM_START ? "<unknown>" : location;
+}
+
+static void GetHeapFragmentation(u32 *largestFree, u32 *totalFree)
+{
+    const struct MemBlock *block = HeapHead();
+
+    *largestFree = 0;
+    *totalFree = 0;
+    do
+    {
+        if (!block->allocated)
+        {
+            *totalFree += block->size;
+            if (*largestFree < block->size)
+                *largestFree = block->size;
+        }
+        block = block->next;
+    } while (block != HeapHead());
+}
+
+#if PROFILE
+
+// Called when the main callback changes, which is when scenes free their
+// data and allocate the next scene's.
+void HeapStats_SampleFragmentation(void (*callback)(void))
+{
+    struct HeapFragmentationSample *sample;
+
+    if (sHeapStart == NULL)
+        return;
+
+    sample = &sHeapSamples[sHeapSamplesCount++ % HEAP_STATS_SAMPLES_COUNT];
+    sample->callback = callback;
+    GetHeapFragmentation(&sample->largestFree, &sample->totalFree);
+    if (sWorstHeapSample.callback == NULL || sample->largestFree < sWorstHeapSample.largestFree)
+        sWorstHeapSample = *sample;
+}
+
+static void PrintHeapSiteStats(void)
+{
+    s32 i, j;
+    u8 order[HEAP_STATS_SITES_COUNT];
+    u32 n = 0;
+    const struct HeapSiteStats *site;
+    const struct HeapFragmentationSample *sample;
+
+    // Largest peak first.
+    for (i = 0; i < HEAP_STATS_SITES_COUNT; i++)
+    {
+        if (sHeapSiteStats[i].location == NULL)
+            continue;
+        for (j = n; j > 0 && sHeapSiteStats[order[j - 1]].peakBytes < sHeapSiteStats[i].peakBytes; j--)
+            order[j] = order[j - 1];
+        order[j] = i;
+        n++;
+    }
+
+    DebugPrintf("HEAP: %u bytes peak, %u allocations and frees not counted", sHeapPeakBytes, sHeapDroppedSites);
+    for (i = 0; i < n; i++)
+    {
+        site = &sHeapSiteStats[order[i]];
+        DebugPrintf("HEAP: %s: %u bytes live, %u bytes peak, %u allocations, %u failures",
+                    LocationName(site->location),
+                    site->liveBytes, site->peakBytes, site->allocs, site->failures);
+    }
+
+    for (i = min(sHeapSamplesCount, HEAP_STATS_SAMPLES_COUNT); i > 0; i--)
+    {
+        sample = &sHeapSamples[(sHeapSamplesCount - i) % HEAP_STATS_SAMPLES_COUNT];
+        DebugPrintf("HEAP: entering 0x%x: largest free %u of %u bytes free", (u32)sample->callback, sample->largestFree, sample->totalFree);
+    }
+    if (sWorstHeapSample.callback != NULL)
+        DebugPrintf("HEAP: worst entering 0x%x: largest free %u of %u bytes free", (u32)sWorstHeapSample.callback, sWorstHeapSample.largestFree, sWorstHeapSample.totalFree);
+}
+
+#endif // PROFILE
+
+void HeapStats_Print(void)
+{
+    u32 largestFree, totalFree;
+    const struct MemBlock *block = HeapHead();
+
+    GetHeapFragmentation(&largestFree, &totalFree);
+    DebugPrintf("HEAP: largest free %u of %u bytes free, %u bytes heap", largestFree, totalFree, sHeapSize);
+    do
+    {
+        if (block->allocated)
+            DebugPrintf("HEAP: 0x%x: %u bytes from %s", (u32)block->data, block->size, LocationName(MemBlockLocation(block)));
+        block = block->next;
+    } while (block != HeapHead());
+
+#if PROFILE
+    PrintHeapSiteStats();
+#endif
 }
@@ -1552,6 +1552,111 @@ bool8 MapHasNaturalLight(u8 mapType)
     );
 }
 
+// Blended palettes, so that reloading a map or an object event's palette
+// does not redo the blend while the time of day has not changed. Entries
+// are keyed by the tileset and palette index, or the sprite palette tag,
+// and hold a copy of the source to catch palettes changed in between
+// (e.g. by palette animations).
+#define TIME_BLEND_CACHE_COUNT 32
+#define TIME_BLEND_CACHE_ALT 0x8000 // id flag for UpdateAltBgPalettes's averages
+
+struct TimeBlendCacheEntry
+{
+    const void *owner; // tileset, or NULL for sprite palettes
+    u16 id; // palette index, or sprite palette tag
+    u16 lastUsed; // 0 if the entry is empty
+    u16 src[16];
+    u16 blended[16];
+};
+
+static EWRAM_DATA struct TimeBlendCacheEntry sTimeBlendCache[TIME_BLEND_CACHE_COUNT] = {0};
+static EWRAM_DATA struct TimeBlendSettings sTimeBlendCacheBlend = {0};
+static EWRAM_DATA u16 sTimeBlendCacheClock = 0;
+
+static void FlushTimeBlendCache(void)
+{
+    CpuFill32(0, sTimeBlendCache, sizeof(sTimeBlendCache));
+    sTimeBlendCacheClock = 0;
+}
+
+// Returns the entry for the palette, and whether it already holds the
+// blend of src. On a miss, the entry is taken over and src is copied in.
+static struct TimeBlendCacheEntry *GetTimeBlendCacheEntry(const void *owner, u32 id, const u16 *src, bool32 *hit)
+{
+    u32 i;
+    struct TimeBlendCacheEntry *entry = NULL;
+    struct TimeBlendCacheEntry *oldest = &sTimeBlendCache[0];
+
+    if (sTimeBlendCacheBlend.time0 != currentTimeBlend.time0
+     || sTimeBlendCacheBlend.time1 != currentTimeBlend.time1
+     || sTimeBlendCacheBlend.weight != currentTimeBlend.weight
+     || sTimeBlendCacheBlend.altWeight != currentTimeBlend.altWeight)
+    {
+        FlushTimeBlendCache();
+        sTimeBlendCacheBlend = currentTimeBlend;
+    }
+    if (++sTimeBlendCacheClock == 0)
+    {
+        FlushTimeBlendCache();
+        sTimeBlendCacheClock = 1;
+    }
+
+    for (i = 0; i < TIME_BLEND_CACHE_COUNT; i++)
+    {
+        if (sTimeBlendCache[i].lastUsed != 0 && sTimeBlendCache[i].owner == owner && sTimeBlendCache[i].id == id)
+        {
+            entry = &sTimeBlendCache[i];
+            break;
+        }
+        if (sTimeBlendCache[i].lastUsed < oldest->lastUsed)
+            oldest = &sTimeBlendCache[i];
+    }
+
+    *hit = entry != NULL && memcmp(entry->src, src, sizeof(entry->src)) == 0;
+    if (entry == NULL)
+        entry = oldest;
+    if (!*hit)
+    {
+        entry->owner = owner;
+        entry->id = id;
+        CpuCopy16(src, entry->src, sizeof(entry->src));
+    }
+    entry->lastUsed = sTimeBlendCacheClock;
+    return entry;
+}
+
+// Blends one palette from unfaded into faded, with the cached result if
+// there is one. Palettes without an owner are always blended.
+static void TimeMixPaletteCached(const void *owner, u32 id, u32 paletteOffset)
+{
+    bool32 hit = FALSE;
+    struct TimeBlendCacheEntry *entry = NULL;
+
+    if (owner != NULL || id != TAG_NONE)
+        entry = GetTimeBlendCacheEntry(owner, id, &gPlttBufferUnfaded[paletteOffset], &hit);
+
+    if (entry == NULL)
+    {
+        TimeMixPalettes(1,
+                        &gPlttBufferUnfaded[paletteOffset],
+                        &gPlttBufferFaded[paletteOffset],
+                        (struct BlendSettings *)&gTimeOfDayBlend[currentTimeBlend.time0],
+                        (struct BlendSettings *)&gTimeOfDayBlend[currentTimeBlend.time1],
+                        currentTimeBlend.weight);
+        return;
+    }
+    if (!hit)
+    {
+        TimeMixPalettes(1,
+                        entry->src,
+                        entry->blended,
+                        (struct BlendSettings *)&gTimeOfDayBlend[currentTimeBlend.time0],
+                        (struct BlendSettings *)&gTimeOfDayBlend[currentTimeBlend.time1],
+                        currentTimeBlend.weight);
+    }
+    CpuCopy16(entry->blended, &gPlttBufferFaded[paletteOffset], PLTT_SIZE_4BPP);
+}
+
 // Update & mix day / night bg palettes (into unfaded)
 void UpdateAltBgPalettes(u16 palettes)
 {
@@ -1572,10 +1677,13 @@ void UpdateAltBgPalettes(u16 palettes)
     {
         if (palettes & 1)
         {
-            if (i < NUM_PALS_IN_PRIMARY)
-                AvgPaletteWeighted(&((u16*)primary->palettes)[i*16], &((u16*)primary->palettes)[((i+9)%16)*16], gPlttBufferUnfaded + i * 16, currentTimeBlend.altWeight);
-            else
-                AvgPaletteWeighted(&((u16*)secondary->palettes)[i*16], &((u16*)secondary->palettes)[((i+9)%16)*16], gPlttBufferUnfaded + i * 16, currentTimeBlend.altWeight);
+            const struct Tileset *tileset = i < NUM_PALS_IN_PRIMARY ? primary : secondary;
+            u16 *src = &((u16*)tileset->palettes)[i*16];
+            bool32 hit;
+            struct TimeBlendCacheEntry *entry = GetTimeBlendCacheEntry(tileset, i | TIME_BLEND_CACHE_ALT, src, &hit);
+            if (!hit)
+                AvgPaletteWeighted(src, &((u16*)tileset->palettes)[((i+9)%16)*16], entry->blended, currentTimeBlend.altWeight);
+            CpuCopy16(entry->blended, gPlttBufferUnfaded + i * 16, PLTT_SIZE_4BPP);
         }
         i++;
         palettes >>= 1;
@@ -1598,14 +1706,17 @@ void UpdatePalettesWithTime(u32 palettes)
         palettes &= PALETTES_MAP | PALETTES_OBJECTS; // Don't blend UI pals
         if (!palettes)
             return;
-        TimeMixPalettes(
-            palettes,
-            gPlttBufferUnfaded,
-            gPlttBufferFaded,
-            (struct BlendSettings *)&gTimeOfDayBlend[currentTimeBlend.time0],
-            (struct BlendSettings *)&gTimeOfDayBlend[currentTimeBlend.time1],
-            currentTimeBlend.weight
-        );
+        for (i = 0; palettes; i++, palettes >>= 1)
+        {
+            if (!(palettes & 1))
+                continue;
+            if (i < NUM_PALS_IN_PRIMARY)
+                TimeMixPaletteCached(GetPrimaryTileset(gMapHeader.mapLayout), i, BG_PLTT_ID(i));
+            else if (i < 16)
+                TimeMixPaletteCached(GetSecondaryTileset(gMapHeader.mapLayout), i, BG_PLTT_ID(i));
+            else
+                TimeMixPaletteCached(NULL, GetSpritePaletteTagByPaletteNum(i - 16), OBJ_PLTT_ID(i - 16));
+        }
     }
 }
 
@@ -1617,13 +1728,7 @@ u8 UpdateSpritePaletteWithTime(u8 paletteNum)
     {
         if (GetSpritePaletteTagByPaletteNum(paletteNum) != 0xFFFF && IS_BLEND_IMMUNE_TAG(GetSpritePaletteTagByPaletteNum(paletteNum)))
             return paletteNum;
-        TimeMixPalettes(1,
-                        &gPlttBufferUnfaded[OBJ_PLTT_ID(paletteNum)],
-                        &gPlttBufferFaded[OBJ_PLTT_ID(paletteNum)],
-                        (struct BlendSettings *)&gTimeOfDayBlend[currentTimeBlend.time0],
-                        (struct BlendSettings *)&gTimeOfDayBlend[currentTimeBlend.time1],
-                        currentTimeBlend.weight
-        );
+        TimeMixPaletteCached(NULL, GetSpritePaletteTagByPaletteNum(paletteNum), OBJ_PLTT_ID(paletteNum));
     }
     return paletteNum;
 }
@@ -20,6 +20,7 @@ static u32 UpdateHardwarePaletteFade(void);
 static void UpdateBlendRegisters(void);
 static bool32 IsSoftwarePaletteFadeFinishing(void);
 static void Task_BlendPalettesGradually(u8 taskId);
+static void BlendSelectedPalettes(u32 selectedPalettes, u32 paletteOffset, u32 coeff, u32 color);
 
 ALIGNED(4) EWRAM_DATA u16 gPlttBufferUnfaded[PLTT_BUFFER_SIZE] = {0};
 ALIGNED(4) EWRAM_DATA u16 gPlttBufferFaded[PLTT_BUFFER_SIZE] = {0};
@@ -347,16 +348,7 @@ static u32 UpdateNormalPaletteFade(void)
             selectedPalettes = gPaletteFade_selectedPalettes >> 16;
             paletteOffset = OBJ_PLTT_OFFSET;
         }
-        while (selectedPalettes)
-        {
-            if (selectedPalettes & 1)
-                BlendPalette(paletteOffset,
-                             16,
-                             gPaletteFade.y,
-                             gPaletteFade.blendColor);
-            selectedPalettes >>= 1;
-            paletteOffset += 16;
-        }
+        BlendSelectedPalettes(selectedPalettes, paletteOffset, gPaletteFade.y, gPaletteFade.blendColor);
         gPaletteFade.objPaletteToggle ^= 1;
         if (!gPaletteFade.objPaletteToggle)
         {
@@ -698,58 +690,56 @@ static bool32 IsSoftwarePaletteFadeFinishing(void)
     }
 }
 
-// optimized based on lucktyphlosion's BlendPalettesFine
+// Blends src into dst by coeff/16, keeping the transparency bit.
 void BlendPalettesFine(u32 palettes, u16 *src, u16 *dst, u32 coeff, u32 color)
 {
-    s32 newR, newG, newB;
+    u16 tables[96];
 
     if (!palettes)
         return;
 
-    coeff *= 2;
-    newR = (color << 27) >> 27;
-    newG = (color << 22) >> 27;
-    newB = (color << 17) >> 27;
+    BuildBlendTables(tables, coeff, color);
 
     do
     {
+        // Transparency is blended (for backdrop reasons)
         if (palettes & 1)
-        {
-            u16 *srcEnd = src + 16;
-            while (src != srcEnd) // Transparency is blended (for backdrop reasons)
-            {
-                u32 srcColor = *src;
-                s32 r = (srcColor << 27) >> 27;
-                s32 g = (srcColor << 22) >> 27;
-                s32 b = (srcColor << 16) >> 26;
-
-                *dst++ = ((r + (((newR - r) * (s32)coeff) >> 5)) << 0)
-                       | ((g + (((newG - g) * (s32)coeff) >> 5)) << 5)
-                       | ((b + (((newB - (b & 31)) * (s32)coeff) >> 5)) << 10);
-                src++;
-            }
-        }
-        else
-        {
-            src += 16;
-            dst += 16;
-        }
+            BlendColors(src, dst, 16, tables, 0x8000);
+        src += 16;
+        dst += 16;
         palettes >>= 1;
     } while (palettes);
 }
 
-void BlendPalettes(u32 selectedPalettes, u8 coeff, u32 color)
+// Blends the selected palettes from paletteOffset on, building the blend
+// tables once for all of them. A single palette is blended directly, which
+// is cheaper than building the tables.
+static void BlendSelectedPalettes(u32 selectedPalettes, u32 paletteOffset, u32 coeff, u32 color)
 {
-    u16 paletteOffset;
+    u16 tables[96];
+    bool32 useTables = (selectedPalettes & (selectedPalettes - 1)) != 0;
+
+    if (useTables)
+        BuildBlendTables(tables, coeff, color);
 
-    for (paletteOffset = 0; selectedPalettes; paletteOffset += 16)
+    for (; selectedPalettes; paletteOffset += 16)
     {
         if (selectedPalettes & 1)
-            BlendPalette(paletteOffset, 16, coeff, color);
+        {
+            if (useTables)
+                BlendColors(&gPlttBufferUnfaded[paletteOffset], &gPlttBufferFaded[paletteOffset], 16, tables, 0);
+            else
+                BlendPalette(paletteOffset, 16, coeff, color);
+        }
         selectedPalettes >>= 1;
     }
 }
 
+void BlendPalettes(u32 selectedPalettes, u8 coeff, u32 color)
+{
+    BlendSelectedPalettes(selectedPalettes, 0, coeff, color);
+}
+
 #define DEFAULT_LIGHT_COLOR 0x3f9f
 
 // Like BlendPalette, but ignores blendColor if the transparency high bit is set
@@ -0,0 +1,198 @@
+#include "global.h"
+#include "dma3.h"
+#include "main.h"
+#include "profile.h"
+
+#if PROFILE
+
+#define PROFILE_ENTRIES_COUNT 64
+#define PROFILE_BUCKETS_COUNT 20 // The last bucket also counts anything slower.
+#define CYCLES_PER_FRAME 280896
+
+// Samples are counted by the position of their highest set bit, which
+// bounds their percentiles within a factor of 2.
+struct ProfileEntry
+{
+    const void *func;
+    u8 kind;
+    u32 count;
+    u32 total;
+    u32 max;
+    u16 buckets[PROFILE_BUCKETS_COUNT];
+};
+
+static EWRAM_DATA struct ProfileEntry sProfileEntries[PROFILE_ENTRIES_COUNT] = {0};
+static EWRAM_DATA u32 sInterruptCycles = 0;
+static EWRAM_DATA u16 sFrames = 0;
+static EWRAM_DATA u16 sLateFrames = 0;
+static EWRAM_DATA u16 sDroppedEntries = 0;
+static EWRAM_DATA u32 sLastVBlankCounter = 0;
+
+static const char *const sProfileKindNames[PROFILE_KINDS_COUNT] =
+{
+    [PROFILE_FRAME] = "Frame",
+    [PROFILE_CALLBACK1] = "CB1",
+    [PROFILE_CALLBACK2] = "CB2",
+    [PROFILE_TASK] = "Task",
+    [PROFILE_ANIMATE_SPRITES] = "AnimateSprites",
+    [PROFILE_BUILD_OAM_BUFFER] = "BuildOamBuffer",
+    [PROFILE_VBLANK] = "VBlank",
+};
+
+// Timer 1 counts cycles and timer 2 counts timer 1's overflows, the same
+// as StartTimer1. SeedRngAndSetTrainerId stops them, so they are
+// restarted every frame.
+static void StartProfileTimers(void)
+{
+    if (!(REG_TM1CNT_H & TIMER_ENABLE))
+    {
+        REG_TM2CNT_L = 0;
+        REG_TM2CNT_H = TIMER_ENABLE | TIMER_COUNTUP;
+        REG_TM1CNT_L = 0;
+        REG_TM1CNT_H = TIMER_ENABLE | TIMER_1CLK;
+    }
+}
+
+static u32 ReadProfileTimers(void)
+{
+    u32 hi, lo;
+    do
+    {
+        hi = REG_TM2CNT_L;
+        lo = REG_TM1CNT_L;
+    } while (hi != REG_TM2CNT_L);
+    return (hi << 16) | lo;
+}
+
+static void RecordSample(enum ProfileKind kind, const void *func, u32 cycles)
+{
+    u32 i, n;
+    u16 ime = REG_IME;
+    struct ProfileEntry *entry;
+
+    REG_IME = 0;
+    i = (((u32)func >> 1) ^ kind) % PROFILE_ENTRIES_COUNT;
+    for (n = 0; n < PROFILE_ENTRIES_COUNT; n++, i = (i + 1) % PROFILE_ENTRIES_COUNT)
+    {
+        entry = &sProfileEntries[i];
+        if (entry->count == 0)
+        {
+            entry->func = func;
+            entry->kind = kind;
+            break;
+        }
+        if (entry->func == func && entry->kind == kind)
+            break;
+    }
+
+    if (n == PROFILE_ENTRIES_COUNT)
+    {
+        sDroppedEntries++;
+    }
+    else
+    {
+        entry->count++;
+        entry->total += cycles;
+        if (entry->max < cycles)
+            entry->max = cycles;
+        entry->buckets[min(cycles == 0 ? 0 : 31 - __builtin_clz(cycles), PROFILE_BUCKETS_COUNT - 1)]++;
+    }
+    REG_IME = ime;
+}
+
+// Returns a timestamp that excludes the time spent in interrupts.
+u32 Profile_Begin(void)
+{
+    return ReadProfileTimers() - sInterruptCycles;
+}
+
+void Profile_End(enum ProfileKind kind, const void *func, u32 begin)
+{
+    RecordSample(kind, func, ReadProfileTimers() - sInterruptCycles - begin);
+}
+
+u32 Profile_BeginInterrupt(void)
+{
+    return ReadProfileTimers();
+}
+
+void Profile_EndInterrupt(enum ProfileKind kind, const void *func, u32 begin)
+{
+    u32 cycles = ReadProfileTimers() - begin;
+    sInterruptCycles += cycles;
+    RecordSample(kind, func, cycles);
+}
+
+// Returns an upper bound of the percentile, exact only for max.
+static u32 Percentile(const struct ProfileEntry *entry, u32 percentile)
+{
+    u32 i, count = 0;
+    u32 rank = (entry->count * percentile + 99) / 100;
+    for (i = 0; i < PROFILE_BUCKETS_COUNT - 1; i++)
+    {
+        count += entry->buckets[i];
+        if (count >= rank)
+            return min((2u << i) - 1, entry->max);
+    }
+    return entry->max;
+}
+
+static void PrintProfile(void)
+{
+    s32 i, j;
+    u8 order[PROFILE_ENTRIES_COUNT];
+    u32 n = 0;
+    struct ProfileEntry entry;
+
+    // Slowest in total first.
+    for (i = 0; i < PROFILE_ENTRIES_COUNT; i++)
+    {
+        if (sProfileEntries[i].count == 0)
+            continue;
+        for (j = n; j > 0 && sProfileEntries[order[j - 1]].total < sProfileEntries[i].total; j--)
+            order[j] = order[j - 1];
+        order[j] = i;
+        n++;
+    }
+
+    DebugPrintf("PROFILE: %u frames, %u late, %u functions not profiled", sFrames, sLateFrames, sDroppedEntries);
+    for (i = 0; i < n; i++)
+    {
+        u16 ime = REG_IME;
+        REG_IME = 0;
+        entry = sProfileEntries[order[i]];
+        REG_IME = ime;
+        DebugPrintf("PROFILE: %s 0x%x: %u calls, %u%% of frames, cycles mean %u, p50 <= %u, p90 <= %u, p99 <= %u, max %u",
+                    sProfileKindNames[entry.kind], (u32)entry.func, entry.count,
+                    entry.total / (sFrames * (CYCLES_PER_FRAME / 100)),
+                    entry.total / entry.count, Percentile(&entry, 50), Percentile(&entry, 90), Percentile(&entry, 99), entry.max);
+    }
+    PrintDma3Stats();
+}
+
+void Profile_EndFrame(void)
+{
+    u16 ime;
+
+    StartProfileTimers();
+
+    sFrames++;
+    if (gMain.vblankCounter1 - sLastVBlankCounter > 1)
+        sLateFrames++;
+
+    if (sFrames >= PROFILE_REPORT_FRAMES)
+    {
+        PrintProfile();
+        ime = REG_IME;
+        REG_IME = 0;
+        memset(sProfileEntries, 0, sizeof(sProfileEntries));
+        REG_IME = ime;
+        sFrames = 0;
+        sLateFrames = 0;
+        sDroppedEntries = 0;
+    }
+
+    sLastVBlankCounter = gMain.vblankCounter1;
+}
+
+#endif // PROFILE
@@ -1,5 +1,6 @@
 #include "global.h"
 #include "gflib.h"
+#include "decompress.h"
 #include "scanline_effect.h"
 #include "task.h"
 #include "m4a.h"
@@ -1130,19 +1131,15 @@ static bool8 LoadRegionMapGfx(void)
             return FALSE;
         break;
     case 5:
-        LZ77UnCompWram(sKanto_Tilemap, sRegionMap->layouts[REGIONMAP_KANTO]);
-        break;
-    case 6:
-        LZ77UnCompWram(sSevii123_Tilemap, sRegionMap->layouts[REGIONMAP_SEVII123]);
-        break;
-    case 7:
-        LZ77UnCompWram(sSevii45_Tilemap, sRegionMap->layouts[REGIONMAP_SEVII45]);
-        break;
-    case 8:
-        LZ77UnCompWram(sSevii67_Tilemap, sRegionMap->layouts[REGIONMAP_SEVII67]);
+        RequestAsyncLZDecompressWram(sKanto_Tilemap, sRegionMap->layouts[REGIONMAP_KANTO], NULL);
+        RequestAsyncLZDecompressWram(sSevii123_Tilemap, sRegionMap->layouts[REGIONMAP_SEVII123], NULL);
+        RequestAsyncLZDecompressWram(sSevii45_Tilemap, sRegionMap->layouts[REGIONMAP_SEVII45], NULL);
+        RequestAsyncLZDecompressWram(sSevii67_Tilemap, sRegionMap->layouts[REGIONMAP_SEVII67], NULL);
+        RequestAsyncLZDecompressWram(sBackground_Tilemap, sRegionMap->layouts[REGIONMAP_COUNT], NULL);
         break;
     default:
-        LZ77UnCompWram(sBackground_Tilemap, sRegionMap->layouts[REGIONMAP_COUNT]);
+        if (IsAsyncDecompressionActive())
+            return FALSE;
         return TRUE;
     }
     sRegionMap->loadGfxState++;
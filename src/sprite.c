@@ -2,6 +2,7 @@
 #include "sprite.h"
 #include "main.h"
 #include "palette.h"
+#include "profile.h"
 
 #define MAX_SPRITE_COPY_REQUESTS 64
 
@@ -14,17 +15,7 @@
     (sSpriteTileRanges + 1)[index * 2] = count;    \
 }
 
-#define ALLOC_SPRITE_TILE(n)                             \
-{                                                        \
-    sSpriteTileAllocBitmap[(n) / 8] |= (1 << ((n) % 8)); \
-}
-
-#define FREE_SPRITE_TILE(n)                               \
-{                                                         \
-    sSpriteTileAllocBitmap[(n) / 8] &= ~(1 << ((n) % 8)); \
-}
-
-#define SPRITE_TILE_IS_ALLOCATED(n) ((sSpriteTileAllocBitmap[(n) / 8] >> ((n) % 8)) & 1)
+#define SPRITE_TILE_IS_ALLOCATED(n) ((sSpriteTileAllocBitmap[(n) / 32] >> ((n) % 32)) & 1)
 
 
 struct SpriteCopyRequest
@@ -51,6 +42,7 @@ static u32 CreateSpriteAt(u32 index, const struct SpriteTemplate *template, s16
 static void ResetOamMatrices(void);
 static void ResetSprite(struct Sprite *sprite);
 static void ResetAllSprites(void);
+static void SetSpriteTilesAllocated(u32 start, u32 count, bool32 allocated);
 static void BeginAnim(struct Sprite *sprite);
 static void ContinueAnim(struct Sprite *sprite);
 static void AnimCmd_frame(struct Sprite *sprite);
@@ -254,6 +246,14 @@ static u16 sSpriteTileRangeTags[MAX_SPRITES];
 static u16 sSpriteTileRanges[MAX_SPRITES * 2];
 static struct AffineAnimState sAffineAnimStates[OAM_MATRIX_COUNT];
 static u16 sSpritePaletteTags[16];
+// Bit n is set if gSprites[n] may be in use, so that AnimateSprites and
+// the free slot searches skip the unused slots. A sprite which is freed
+// by clearing its inUse instead of DestroySprite keeps its bit until it
+// is next looked at. A sprite which is copied into a slot without
+// MarkSpriteInUse is drawn, but is not animated and its slot may be
+// handed out again.
+static u32 sActiveSprites[MAX_SPRITES / 32];
+STATIC_ASSERT(MAX_SPRITES % 32 == 0, ActiveSpritesMustBeWholeWords);
 
 // iwram common
 COMMON_DATA u32 gOamMatrixAllocBitmap = 0;
@@ -267,12 +267,72 @@ EWRAM_DATA static struct SpriteCopyRequest sSpriteCopyRequests[MAX_SPRITES] = {0
 EWRAM_DATA u8 gOamLimit = 0;
 static EWRAM_DATA u8 sOamDummyIndex = 0;
 EWRAM_DATA u16 gReservedSpriteTileCount = 0;
-EWRAM_DATA static u8 sSpriteTileAllocBitmap[128] = {0};
+EWRAM_DATA static u32 sSpriteTileAllocBitmap[TOTAL_OBJ_TILE_COUNT / 32] = {0};
 EWRAM_DATA s16 gSpriteCoordOffsetX = 0;
 EWRAM_DATA s16 gSpriteCoordOffsetY = 0;
 EWRAM_DATA struct OamMatrix gOamMatrices[OAM_MATRIX_COUNT] = {0};
 EWRAM_DATA bool8 gAffineAnimsDisabled = FALSE;
 
+static inline void SetSpriteActive(u32 index)
+{
+    sActiveSprites[index / 32] |= 1u << (index % 32);
+}
+
+static inline void ClearSpriteActive(u32 index)
+{
+    sActiveSprites[index / 32] &= ~(1u << (index % 32));
+}
+
+// Returns the first sprite from index on which may be in use, or
+// MAX_SPRITES if there is none.
+static inline u32 NextActiveSprite(u32 index)
+{
+    while (index < MAX_SPRITES)
+    {
+        u32 bits = sActiveSprites[index / 32] & (~0u << (index % 32));
+        if (bits != 0)
+            return (index & ~31) + __builtin_ctz(bits);
+        index = (index & ~31) + 32;
+    }
+    return MAX_SPRITES;
+}
+
+static void PruneActiveSprites(void)
+{
+    u32 i;
+    for (i = NextActiveSprite(0); i < MAX_SPRITES; i = NextActiveSprite(i + 1))
+    {
+        if (!gSprites[i].inUse)
+            ClearSpriteActive(i);
+    }
+}
+
+// Returns the first (or last) sprite which is not in use, the same as a
+// scan of gSprites' inUse would, or MAX_SPRITES if all are.
+static u32 FindFreeSprite(bool32 fromEnd)
+{
+    s32 i;
+
+    PruneActiveSprites();
+    if (fromEnd)
+    {
+        for (i = ARRAY_COUNT(sActiveSprites) - 1; i >= 0; i--)
+        {
+            if (~sActiveSprites[i] != 0)
+                return i * 32 + 31 - __builtin_clz(~sActiveSprites[i]);
+        }
+    }
+    else
+    {
+        for (i = 0; i < ARRAY_COUNT(sActiveSprites); i++)
+        {
+            if (~sActiveSprites[i] != 0)
+                return i * 32 + __builtin_ctz(~sActiveSprites[i]);
+        }
+    }
+    return MAX_SPRITES;
+}
+
 void ResetSpriteData(void)
 {
     ResetOamRange(0, 128);
@@ -291,7 +351,10 @@ void ResetSpriteData(void)
 void AnimateSprites(void)
 {
     u32 i;
-    for (i = 0; i < MAX_SPRITES; i++)
+    u32 profile = Profile_Begin();
+    // Sprites which are created by a callback are run in the same frame if
+    // they are after it, as when every slot was checked.
+    for (i = NextActiveSprite(0); i < MAX_SPRITES; i = NextActiveSprite(i + 1))
     {
         struct Sprite *sprite = &gSprites[i];
 
@@ -302,7 +365,12 @@ void AnimateSprites(void)
             if (sprite->inUse)
                 AnimateSprite(sprite);
         }
+        else
+        {
+            ClearSpriteActive(i);
+        }
     }
+    Profile_End(PROFILE_ANIMATE_SPRITES, AnimateSprites, profile);
 }
 
 void BuildOamBuffer(void)
@@ -321,6 +389,7 @@ void BuildOamBuffer(void)
     u8 skippedSprites[MAX_SPRITES];
     u32 skippedSpritesN = 0;
     u32 matrices = 0;
+    u32 profile = Profile_Begin();
 
     for (i = 0; i < MAX_SPRITES; i++)
     {
@@ -407,6 +476,7 @@ void BuildOamBuffer(void)
 
     gMain.oamLoadDisabled = oamLoadDisabled;
     sShouldProcessSpriteCopyRequests = TRUE;
+    Profile_End(PROFILE_BUILD_OAM_BUFFER, BuildOamBuffer, profile);
 }
 
 static inline void InsertionSort(u32 *spritePriorities, s32 n)
@@ -433,24 +503,22 @@ static void SortSprites(u32 *spritePriorities, s32 n)
 
 u32 CreateSprite(const struct SpriteTemplate *template, s16 x, s16 y, u32 subpriority)
 {
-    u32 i;
+    u32 i = FindFreeSprite(FALSE);
 
-    for (i = 0; i < MAX_SPRITES; i++)
-        if (!gSprites[i].inUse)
-            return CreateSpriteAt(i, template, x, y, subpriority);
+    if (i == MAX_SPRITES)
+        return MAX_SPRITES;
 
-    return MAX_SPRITES;
+    return CreateSpriteAt(i, template, x, y, subpriority);
 }
 
 u32 CreateSpriteAtEnd(const struct SpriteTemplate *template, s16 x, s16 y, u32 subpriority)
 {
-    s32 i;
+    u32 i = FindFreeSprite(TRUE);
 
-    for (i = MAX_SPRITES - 1; i > -1; i--)
-        if (!gSprites[i].inUse)
-            return CreateSpriteAt(i, template, x, y, subpriority);
+    if (i == MAX_SPRITES)
+        return MAX_SPRITES;
 
-    return MAX_SPRITES;
+    return CreateSpriteAt(i, template, x, y, subpriority);
 }
 
 u32 CreateInvisibleSprite(void (*callback)(struct Sprite *))
@@ -476,6 +544,7 @@ u32 CreateSpriteAt(u32 index, const struct SpriteTemplate *template, s16 x, s16
     ResetSprite(sprite);
 
     sprite->inUse = TRUE;
+    SetSpriteActive(index);
     sprite->animBeginning = TRUE;
     sprite->affineAnimBeginning = TRUE;
     sprite->usingSheet = TRUE;
@@ -522,29 +591,24 @@ u32 CreateSpriteAt(u32 index, const struct SpriteTemplate *template, s16 x, s16
 
 u32 CreateSpriteAndAnimate(const struct SpriteTemplate *template, s16 x, s16 y, u32 subpriority)
 {
-    u32 i;
-
-    for (i = 0; i < MAX_SPRITES; i++)
-    {
-        struct Sprite *sprite = &gSprites[i];
+    u32 i = FindFreeSprite(FALSE);
+    struct Sprite *sprite = &gSprites[i];
 
-        if (!gSprites[i].inUse)
-        {
-            u32 index = CreateSpriteAt(i, template, x, y, subpriority);
-
-            if (index == MAX_SPRITES)
-                return MAX_SPRITES;
+    if (i == MAX_SPRITES || CreateSpriteAt(i, template, x, y, subpriority) == MAX_SPRITES)
+        return MAX_SPRITES;
 
-            gSprites[i].callback(sprite);
+    sprite->callback(sprite);
 
-            if (gSprites[i].inUse)
-                AnimateSprite(sprite);
+    if (sprite->inUse)
+        AnimateSprite(sprite);
 
-            return index;
-        }
-    }
+    return i;
+}
 
-    return MAX_SPRITES;
+void MarkSpriteInUse(u32 spriteId)
+{
+    gSprites[spriteId].inUse = TRUE;
+    SetSpriteActive(spriteId);
 }
 
 void DestroySprite(struct Sprite *sprite)
@@ -552,12 +616,7 @@ void DestroySprite(struct Sprite *sprite)
     if (sprite->inUse)
     {
         if (!sprite->usingSheet)
-        {
-            u16 i;
-            u16 tileEnd = (sprite->images->size / TILE_SIZE_4BPP) + sprite->oam.tileNum;
-            for (i = sprite->oam.tileNum; i < tileEnd; i++)
-                FREE_SPRITE_TILE(i);
-        }
+            SetSpriteTilesAllocated(sprite->oam.tileNum, sprite->images->size / TILE_SIZE_4BPP, FALSE);
         ResetSprite(sprite);
     }
 }
@@ -613,6 +672,8 @@ void SetOamMatrix(u8 matrixNum, u16 a, u16 b, u16 c, u16 d)
 
 void ResetSprite(struct Sprite *sprite)
 {
+    if (sprite >= gSprites && sprite < &gSprites[MAX_SPRITES])
+        ClearSpriteActive(sprite - gSprites);
     *sprite = sDummySprite;
 }
 
@@ -631,83 +692,73 @@ void CalcCenterToCornerVec(struct Sprite *sprite, u8 shape, u8 size, u8 affineMo
     sprite->centerToCornerVecY = y;
 }
 
+// Returns the first tile from i on which is allocated (or free), or
+// TOTAL_OBJ_TILE_COUNT if there is none.
+static u32 NextSpriteTile(u32 i, bool32 allocated)
+{
+    while (i < TOTAL_OBJ_TILE_COUNT)
+    {
+        u32 bits = sSpriteTileAllocBitmap[i / 32];
+        if (!allocated)
+            bits = ~bits;
+        bits &= ~0u << (i % 32);
+        if (bits != 0)
+            return (i & ~31) + __builtin_ctz(bits);
+        i = (i & ~31) + 32;
+    }
+    return TOTAL_OBJ_TILE_COUNT;
+}
+
+static void SetSpriteTilesAllocated(u32 start, u32 count, bool32 allocated)
+{
+    u32 end = min(start + count, TOTAL_OBJ_TILE_COUNT);
+    while (start < end)
+    {
+        u32 n = min(32 - start % 32, end - start);
+        u32 mask = (n == 32 ? ~0u : (1u << n) - 1) << (start % 32);
+        if (allocated)
+            sSpriteTileAllocBitmap[start / 32] |= mask;
+        else
+            sSpriteTileAllocBitmap[start / 32] &= ~mask;
+        start += n;
+    }
+}
+
 s16 AllocSpriteTiles(u16 tileCount)
 {
-    u16 i;
-    s16 start;
-    u16 numTilesFound;
+    u32 start, end;
 
     if (tileCount == 0)
     {
         // Free all unreserved tiles if the tile count is 0.
-        for (i = gReservedSpriteTileCount; i < TOTAL_OBJ_TILE_COUNT; i++)
-            FREE_SPRITE_TILE(i);
-
+        SetSpriteTilesAllocated(gReservedSpriteTileCount, TOTAL_OBJ_TILE_COUNT - gReservedSpriteTileCount, FALSE);
         return 0;
     }
 
-    i = gReservedSpriteTileCount;
-
-    for (;;)
+    // The first run of free tiles which is long enough.
+    end = gReservedSpriteTileCount;
+    do
     {
-        while (SPRITE_TILE_IS_ALLOCATED(i))
-        {
-            i++;
-
-            if (i == TOTAL_OBJ_TILE_COUNT)
-                return -1;
-        }
-
-        start = i;
-        numTilesFound = 1;
-
-        while (numTilesFound != tileCount)
-        {
-            i++;
-
-            if (i == TOTAL_OBJ_TILE_COUNT)
-                return -1;
-
-            if (!SPRITE_TILE_IS_ALLOCATED(i))
-                numTilesFound++;
-            else
-                break;
-        }
-
-        if (numTilesFound == tileCount)
-            break;
-    }
-
-    for (i = start; i < tileCount + start; i++)
-        ALLOC_SPRITE_TILE(i);
+        start = NextSpriteTile(end, FALSE);
+        if (start + tileCount > TOTAL_OBJ_TILE_COUNT)
+            return -1;
+        end = NextSpriteTile(start, TRUE);
+    } while (end - start < tileCount);
 
+    SetSpriteTilesAllocated(start, tileCount, TRUE);
     return start;
 }
 
 u8 SpriteTileAllocBitmapOp(u16 bit, u8 op)
 {
-    u8 index = bit / 8;
-    u8 shift = bit % 8;
-    u8 val = bit % 8;
-    u8 retVal = 0;
-
     if (op == 0)
-    {
-        val = ~(1 << val);
-        sSpriteTileAllocBitmap[index] &= val;
-    }
+        SetSpriteTilesAllocated(bit, 1, FALSE);
     else if (op == 1)
-    {
-        val = (1 << val);
-        sSpriteTileAllocBitmap[index] |= val;
-    }
+        SetSpriteTilesAllocated(bit, 1, TRUE);
     else
-    {
-        retVal = 1 << shift;
-        retVal &= sSpriteTileAllocBitmap[index];
-    }
+        return SPRITE_TILE_IS_ALLOCATED(bit) << (bit % 8);
 
-    return retVal;
+    return 0;
 }
 
 void SpriteCallbackDummy(struct Sprite *sprite)
@@ -783,6 +834,14 @@ void CopyToSprites(u8 *src)
         src++;
         dest++;
     }
+
+    for (i = 0; i < MAX_SPRITES; i++)
+    {
+        if (gSprites[i].inUse)
+            SetSpriteActive(i);
+        else
+            ClearSpriteActive(i);
+    }
 }
 
 void ResetAllSprites(void)
@@ -1492,7 +1551,6 @@ void FreeSpriteTilesByTag(u16 tag)
     u8 index = IndexOfSpriteTileTag(tag);
     if (index != 0xFF)
     {
-        u16 i;
         u16 *rangeStarts;
         u16 *rangeCounts;
         u16 start;
@@ -1502,8 +1560,7 @@ void FreeSpriteTilesByTag(u16 tag)
         rangeCounts = sSpriteTileRanges + 1;
         count = rangeCounts[index * 2];
 
-        for (i = start; i < start + count; i++)
-            FREE_SPRITE_TILE(i);
+        SetSpriteTilesAllocated(start, count, FALSE);
 
         sSpriteTileRangeTags[index] = TAG_NONE;
     }
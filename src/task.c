@@ -1,4 +1,5 @@
 #include "global.h"
+#include "profile.h"
 #include "task.h"
 
 COMMON_DATA struct Task gTasks[NUM_TASKS] = {0};
@@ -115,7 +116,10 @@ void RunTasks(void)
     {
         do
         {
-            gTasks[taskId].func(taskId);
+            TaskFunc func = gTasks[taskId].func;
+            u32 profile = Profile_Begin();
+            func(taskId);
+            Profile_End(PROFILE_TASK, func, profile);
             taskId = gTasks[taskId].next;
         } while (taskId != TAIL_SENTINEL);
     }
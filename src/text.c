@@ -398,7 +398,7 @@ void RunTextPrinters(void)
             switch (renderCmd)
             {
             case RENDER_PRINT:
-                CopyWindowToVram(sTextPrinters[i].printerTemplate.windowId, COPYWIN_GFX);
+                CopyWindowDirtyTilesToVram(sTextPrinters[i].printerTemplate.windowId);
             case RENDER_UPDATE:
                 if (sTextPrinters[i].callback != NULL)
                     sTextPrinters[i].callback(&sTextPrinters[i].printerTemplate, renderCmd);
@@ -636,26 +636,44 @@ static u8 UNUSED GetLastTextColor(u8 colorType)
     }
 }
 
-inline static void GLYPH_COPY(u8 *windowTiles, u32 widthOffset, u32 j, u32 i, u32 *glyphPixels, s32 width, s32 height)
+// Draws up to 8x8 pixels of a glyph at (x, y) a tile row at a time,
+// leaving the pixels of color 0 transparent.
+IWRAM_CODE static void GLYPH_COPY(u8 *windowTiles, u32 widthOffset, u32 x, u32 y, u32 *glyphPixels, s32 width, s32 height)
 {
-    u32 xAdd, yAdd, pixelData, bits, toOrr, dummyX;
-    u8 *dst;
+    u32 i, pixels, mask, widthMask;
+    u32 shift = (x % 8) * 4;
+    u32 *row;
 
-    xAdd = j + width;
-    yAdd = i + height;
-    dummyX = j;
-    for (; i < yAdd; i++)
+    if (width <= 0 || height <= 0)
+        return;
+
+    widthMask = width >= 8 ? 0xFFFFFFFF : (1u << (width * 4)) - 1;
+    windowTiles += (x / 8) * 32;
+
+    if (shift == 0)
     {
-        pixelData = *glyphPixels++;
-        for (j = dummyX; j < xAdd; j++)
+        // Tile-aligned, so each row is one word.
+        for (i = y; i < y + height; i++)
         {
-            if ((toOrr = pixelData & 0xF))
-            {
-                dst = windowTiles + ((j / 8) * 32) + ((j % 8) / 2) + ((i / 8) * widthOffset) + ((i % 8) * 4);
-                bits = ((j & 1) * 4);
-                *dst = (toOrr << bits) | (*dst & (0xF0 >> bits));
-            }
-            pixelData >>= 4;
+            pixels = *glyphPixels++ & widthMask;
+            mask = pixels | (pixels >> 1) | (pixels >> 2) | (pixels >> 3);
+            mask = (mask & 0x11111111) * 0xF;
+            row = (u32 *)(windowTiles + (i / 8) * widthOffset + (i % 8) * 4);
+            *row = (*row & ~mask) | pixels;
+        }
+    }
+    else
+    {
+        // Each row spans the same row of two tiles.
+        for (i = y; i < y + height; i++)
+        {
+            pixels = *glyphPixels++ & widthMask;
+            mask = pixels | (pixels >> 1) | (pixels >> 2) | (pixels >> 3);
+            mask = (mask & 0x11111111) * 0xF;
+            row = (u32 *)(windowTiles + (i / 8) * widthOffset + (i % 8) * 4);
+            row[0] = (row[0] & ~(mask << shift)) | (pixels << shift);
+            if (mask >> (32 - shift))
+                row[8] = (row[8] & ~(mask >> (32 - shift))) | (pixels >> (32 - shift));
         }
     }
 }
@@ -711,6 +729,9 @@ void CopyGlyphToWindow(struct TextPrinter *textPrinter)
             GLYPH_COPY(windowTiles, widthOffset, currX + 8, currY + 8, glyphPixels + 24, glyphWidth - 8, glyphHeight - 8);
         }
     }
+
+    if (glyphWidth > 0 && glyphHeight > 0)
+        MarkWindowDirty(textPrinter->printerTemplate.windowId, currX, currY, glyphWidth, glyphHeight);
 }
 
 void ClearTextSpan(struct TextPrinter *textPrinter, u32 width)
@@ -737,6 +758,11 @@ void ClearTextSpan(struct TextPrinter *textPrinter, u32 width)
             width,
             *glyphHeight,
             sLastTextBgColor);
+        MarkWindowDirty(textPrinter->printerTemplate.windowId,
+                        textPrinter->printerTemplate.currentX,
+                        textPrinter->printerTemplate.currentY,
+                        width,
+                        *glyphHeight);
     }
 }
 
@@ -942,7 +968,7 @@ void TextPrinterDrawDownArrow(struct TextPrinter *textPrinter)
                 textPrinter->printerTemplate.currentY,
                 10,
                 12);
-            CopyWindowToVram(textPrinter->printerTemplate.windowId, COPYWIN_GFX);
+            CopyWindowDirtyTilesToVram(textPrinter->printerTemplate.windowId);
 
             subStruct->downArrowDelay = 8;
             subStruct->downArrowYPosIdx++;
@@ -959,7 +985,7 @@ void TextPrinterClearDownArrow(struct TextPrinter *textPrinter)
         textPrinter->printerTemplate.currentY,
         10,
         12);
-    CopyWindowToVram(textPrinter->printerTemplate.windowId, COPYWIN_GFX);
+    CopyWindowDirtyTilesToVram(textPrinter->printerTemplate.windowId);
 }
 
 bool32 TextPrinterWaitAutoMode(struct TextPrinter *textPrinter)
@@ -1057,13 +1083,137 @@ void DrawDownArrow(u8 windowId, u16 x, u16 y, u8 bgColor, bool32 drawArrow, u8 *
                 y,
                 10,
                 12);
-            CopyWindowToVram(windowId, COPYWIN_GFX);
+            CopyWindowDirtyTilesToVram(windowId);
             *counter = 8;
             ++*yCoordIndex;
         }
     }
 }
 
+#define GLYPH_CACHE_COUNT 32
+
+// Glyphs which have been decompressed recently, with the colors they were
+// decompressed with.
+struct GlyphCacheEntry
+{
+    u32 key;
+    u32 lastUse;
+    struct TextGlyph glyph;
+};
+
+static EWRAM_DATA struct GlyphCacheEntry sGlyphCache[GLYPH_CACHE_COUNT] = {0};
+static EWRAM_DATA u32 sGlyphCacheClock = 0;
+
+static void DecompressGlyphUncached(u32 fontId, u16 glyphId, bool32 isJapanese)
+{
+    switch (fontId)
+    {
+    case FONT_SMALL:
+        DecompressGlyph_Small(glyphId, isJapanese);
+        break;
+    case FONT_NORMAL_COPY_1:
+        DecompressGlyph_NormalCopy1(glyphId, isJapanese);
+        break;
+    case FONT_NORMAL:
+        DecompressGlyph_Normal(glyphId, isJapanese);
+        break;
+    case FONT_NORMAL_COPY_2:
+        DecompressGlyph_NormalCopy2(glyphId, isJapanese);
+        break;
+    case FONT_MALE:
+        DecompressGlyph_Male(glyphId, isJapanese);
+        break;
+    case FONT_FEMALE:
+        DecompressGlyph_Female(glyphId, isJapanese);
+        break;
+    case FONT_NARROW:
+        DecompressGlyph_Narrow(glyphId, isJapanese);
+        break;
+    case FONT_SMALL_NARROW:
+        DecompressGlyph_SmallNarrow(glyphId, isJapanese);
+        break;
+    case FONT_NARROWER:
+        DecompressGlyph_Narrower(glyphId, isJapanese);
+        break;
+    case FONT_SMALL_NARROWER:
+        DecompressGlyph_SmallNarrower(glyphId, isJapanese);
+        break;
+    case FONT_SHORT_NARROW:
+        DecompressGlyph_ShortNarrow(glyphId, isJapanese);
+        break;
+    case FONT_SHORT:
+        DecompressGlyph_Short(glyphId, isJapanese);
+        break;
+    }
+}
+
+// Forgets every cached glyph, so that each is decompressed again.
+void ClearGlyphCache(void)
+{
+    memset(sGlyphCache, 0, sizeof(sGlyphCache));
+    sGlyphCacheClock = 0;
+}
+
+// Decompresses a glyph into gCurGlyph with the current text colors.
+static void DecompressGlyph(u32 fontId, u16 glyphId, bool32 isJapanese)
+{
+    u32 i;
+    struct GlyphCacheEntry *entry = &sGlyphCache[0];
+    u32 key = (1u << 31)
+            | glyphId
+            | (fontId << 9)
+            | (isJapanese ? 1u << 13 : 0)
+            | ((sLastTextFgColor & 0xF) << 14)
+            | ((sLastTextBgColor & 0xF) << 18)
+            | ((sLastTextShadowColor & 0xF) << 22);
+
+    sGlyphCacheClock++;
+    for (i = 0; i < GLYPH_CACHE_COUNT; i++)
+    {
+        if (sGlyphCache[i].key == key)
+        {
+            sGlyphCache[i].lastUse = sGlyphCacheClock;
+            gCurGlyph = sGlyphCache[i].glyph;
+            return;
+        }
+        if (sGlyphCache[i].lastUse < entry->lastUse)
+            entry = &sGlyphCache[i];
+    }
+
+    // Replace the least recently used glyph.
+    DecompressGlyphUncached(fontId, glyphId, isJapanese);
+    entry->key = key;
+    entry->lastUse = sGlyphCacheClock;
+    entry->glyph = gCurGlyph;
+}
+
+static void RenderGlyph(struct TextPrinter *textPrinter, u16 currChar)
+{
+    struct TextPrinterSubStruct *subStruct = (struct TextPrinterSubStruct *)(&textPrinter->subStructFields);
+    s32 width;
+
+    DecompressGlyph(subStruct->fontId, currChar, textPrinter->japanese);
+    CopyGlyphToWindow(textPrinter);
+
+    if (textPrinter->minLetterSpacing)
+    {
+        textPrinter->printerTemplate.currentX += gCurGlyph.width;
+        width = textPrinter->minLetterSpacing - gCurGlyph.width;
+        if (width > 0)
+        {
+            ClearTextSpan(textPrinter, width);
+            textPrinter->printerTemplate.currentX += width;
+        }
+    }
+    else
+    {
+        if (textPrinter->japanese)
+            textPrinter->printerTemplate.currentX += (gCurGlyph.width + textPrinter->printerTemplate.letterSpacing);
+        else
+            textPrinter->printerTemplate.currentX += gCurGlyph.width;
+    }
+}
+
 static u16 RenderText(struct TextPrinter *textPrinter)
 {
     struct TextPrinterSubStruct *subStruct = (struct TextPrinterSubStruct *)(&textPrinter->subStructFields);
@@ -1252,65 +1402,18 @@ static u16 RenderText(struct TextPrinter *textPrinter)
             return RENDER_FINISH;
         }
 
-        switch (subStruct->fontId)
-        {
-        case FONT_SMALL:
-            DecompressGlyph_Small(currChar, textPrinter->japanese);
-            break;
-        case FONT_NORMAL_COPY_1:
-            DecompressGlyph_NormalCopy1(currChar, textPrinter->japanese);
-            break;
-        case FONT_NORMAL:
-            DecompressGlyph_Normal(currChar, textPrinter->japanese);
-            break;
-        case FONT_NORMAL_COPY_2:
-            DecompressGlyph_NormalCopy2(currChar, textPrinter->japanese);
-            break;
-        case FONT_MALE:
-            DecompressGlyph_Male(currChar, textPrinter->japanese);
-            break;
-        case FONT_FEMALE:
-            DecompressGlyph_Female(currChar, textPrinter->japanese);
-            break;
-        case FONT_NARROW:
-            DecompressGlyph_Narrow(currChar, textPrinter->japanese);
-            break;
-        case FONT_SMALL_NARROW:
-            DecompressGlyph_SmallNarrow(currChar, textPrinter->japanese);
-            break;
-        case FONT_NARROWER:
-            DecompressGlyph_Narrower(currChar, textPrinter->japanese);
-            break;
-        case FONT_SMALL_NARROWER:
-            DecompressGlyph_SmallNarrower(currChar, textPrinter->japanese);
-            break;
-        case FONT_SHORT_NARROW:
-            DecompressGlyph_ShortNarrow(currChar, textPrinter->japanese);
-            break;
-        case FONT_SHORT:
-            DecompressGlyph_Short(currChar, textPrinter->japanese);
-            break;
-        }
-
-        CopyGlyphToWindow(textPrinter);
+        RenderGlyph(textPrinter, currChar);
 
-        if (textPrinter->minLetterSpacing)
+        // Printing instantly, so draw the rest of the run of glyphs now
+        // instead of returning to the caller for each.
+        if (textPrinter == &sTempTextPrinter)
         {
-            textPrinter->printerTemplate.currentX += gCurGlyph.width;
-            width = textPrinter->minLetterSpacing - gCurGlyph.width;
-            if (width > 0)
+            while ((currChar = *textPrinter->printerTemplate.currentChar) < CHAR_KEYPAD_ICON)
             {
-                ClearTextSpan(textPrinter, width);
-                textPrinter->printerTemplate.currentX += width;
+                textPrinter->printerTemplate.currentChar++;
+                RenderGlyph(textPrinter, currChar);
             }
         }
-        else
-        {
-            if (textPrinter->japanese)
-                textPrinter->printerTemplate.currentX += (gCurGlyph.width + textPrinter->printerTemplate.letterSpacing);
-            else
-                textPrinter->printerTemplate.currentX += gCurGlyph.width;
-        }
         return RENDER_PRINT;
     case RENDER_STATE_WAIT:
         if (TextPrinterWait(textPrinter))
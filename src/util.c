@@ -275,9 +275,54 @@ u32 CalcByteArraySum(const u8 * array, u32 size)
 
     return result;
 }
+// Fills tables with each channel's value blended with blendColor by
+// coeff/16, shifted into place: 32 reds, then 32 greens, then 32 blues.
+// Blending a color is then three lookups instead of three multiplies.
+void BuildBlendTables(u16 *tables, u32 coeff, u32 blendColor)
+{
+    s32 i;
+    s32 r = (blendColor >> 0) & 0x1F;
+    s32 g = (blendColor >> 5) & 0x1F;
+    s32 b = (blendColor >> 10) & 0x1F;
+
+    for (i = 0; i < 32; i++)
+    {
+        tables[i] = (i + (((r - i) * (s32)coeff) >> 4)) << 0;
+        tables[32 + i] = (i + (((g - i) * (s32)coeff) >> 4)) << 5;
+        tables[64 + i] = (i + (((b - i) * (s32)coeff) >> 4)) << 10;
+    }
+}
+
+// Blends count colors with the tables from BuildBlendTables, keeping the
+// bits of keepMask from the source color.
+IWRAM_CODE void BlendColors(const u16 *src, u16 *dst, u32 count, const u16 *tables, u32 keepMask)
+{
+    while (count != 0)
+    {
+        u32 color = *src++;
+        *dst++ = tables[color & 0x1F]
+               | tables[32 + ((color >> 5) & 0x1F)]
+               | tables[64 + ((color >> 10) & 0x1F)]
+               | (color & keepMask);
+        count--;
+    }
+}
+
+// Building the tables costs as much as blending 32 colors directly, so
+// blends of up to that many colors do not use them.
 void BlendPalette(u16 palOffset, u16 numEntries, u8 coeff, u32 blendColor)
 {
     u16 i;
+
+    if (numEntries > 32)
+    {
+        u16 tables[96];
+
+        BuildBlendTables(tables, coeff, blendColor);
+        BlendColors(&gPlttBufferUnfaded[palOffset], &gPlttBufferFaded[palOffset], numEntries, tables, 0);
+        return;
+    }
+
     for (i = 0; i < numEntries; i++)
     {
         u16 index = i + palOffset;
@@ -15,6 +15,8 @@ EWRAM_DATA static u16 sWindowSize = 0;
 
 static u32 GetNumActiveWindowsOnBg(u32 bgId);
 static u32 GetNumActiveWindowsOnBg8Bit(u32 bgId);
+static void MarkWindowAllDirty(u32 windowId);
+static void ClearWindowDirty(u32 windowId);
 
 static const struct WindowTemplate sDummyWindowTemplate = DUMMY_WIN_TEMPLATE;
 
@@ -94,6 +96,7 @@ bool32 InitWindows(const struct WindowTemplate *templates)
 
         gWindows[i].tileData = allocatedTilemapBuffer;
         gWindows[i].window = templates[i];
+        MarkWindowAllDirty(i);
 
         if (gWindowTileAutoAllocEnabled == TRUE)
         {
@@ -168,6 +171,7 @@ u32 AddWindow(const struct WindowTemplate *template)
 
     gWindows[win].tileData = allocatedTilemapBuffer;
     gWindows[win].window = *template;
+    MarkWindowAllDirty(win);
 
     if (gWindowTileAutoAllocEnabled == TRUE)
     {
@@ -275,10 +279,12 @@ void CopyWindowToVram(u32 windowId, u32 mode)
         break;
     case COPYWIN_GFX:
         LoadBgTiles(windowLocal.window.bg, windowLocal.tileData, windowSize, windowLocal.window.baseBlock);
+        ClearWindowDirty(windowId);
         break;
     case COPYWIN_FULL:
         LoadBgTiles(windowLocal.window.bg, windowLocal.tileData, windowSize, windowLocal.window.baseBlock);
         CopyBgTilemapBufferToVram(windowLocal.window.bg);
+        ClearWindowDirty(windowId);
         break;
     }
 }
@@ -316,6 +322,65 @@ void CopyWindowRectToVram(u32 windowId, u32 mode, u32 x, u32 y, u32 w, u32 h)
     }
 }
 
+// Copies only the tiles which have changed since the window was last
+// copied, which is cheaper than CopyWindowToVram(windowId, COPYWIN_GFX)
+// when e.g. printing a glyph. Unlike CopyWindowToVram, this does not
+// restore tiles which something else has overwritten in VRAM.
+void CopyWindowDirtyTilesToVram(u32 windowId)
+{
+    struct Window *window = &gWindows[windowId];
+
+    if (window->dirtyRight > window->dirtyLeft && window->dirtyBottom > window->dirtyTop)
+    {
+        CopyWindowRectToVram(windowId, COPYWIN_GFX,
+                             window->dirtyLeft, window->dirtyTop,
+                             window->dirtyRight - window->dirtyLeft, window->dirtyBottom - window->dirtyTop);
+        ClearWindowDirty(windowId);
+    }
+}
+
+// Marks the tiles under a rect of pixels as changed.
+void MarkWindowDirty(u32 windowId, u32 x, u32 y, u32 width, u32 height)
+{
+    struct Window *window = &gWindows[windowId];
+    u32 left = x / TILE_WIDTH;
+    u32 top = y / TILE_HEIGHT;
+    u32 right = min((x + width + TILE_WIDTH - 1) / TILE_WIDTH, window->window.width);
+    u32 bottom = min((y + height + TILE_HEIGHT - 1) / TILE_HEIGHT, window->window.height);
+
+    if (left >= right || top >= bottom)
+        return;
+
+    if (window->dirtyRight <= window->dirtyLeft || window->dirtyBottom <= window->dirtyTop)
+    {
+        window->dirtyLeft = left;
+        window->dirtyTop = top;
+        window->dirtyRight = right;
+        window->dirtyBottom = bottom;
+    }
+    else
+    {
+        window->dirtyLeft = min(window->dirtyLeft, left);
+        window->dirtyTop = min(window->dirtyTop, top);
+        window->dirtyRight = max(window->dirtyRight, right);
+        window->dirtyBottom = max(window->dirtyBottom, bottom);
+    }
+}
+
+static void MarkWindowAllDirty(u32 windowId)
+{
+    gWindows[windowId].dirtyLeft = 0;
+    gWindows[windowId].dirtyTop = 0;
+    gWindows[windowId].dirtyRight = gWindows[windowId].window.width;
+    gWindows[windowId].dirtyBottom = gWindows[windowId].window.height;
+}
+
+static void ClearWindowDirty(u32 windowId)
+{
+    gWindows[windowId].dirtyRight = 0;
+    gWindows[windowId].dirtyBottom = 0;
+}
+
 void PutWindowTilemap(u32 windowId)
 {
     struct Window windowLocal = gWindows[windowId];
@@ -409,6 +474,7 @@ void BlitBitmapRectToWindow(u32 windowId, const u8 *pixels, u16 srcX, u16 srcY,
     destRect.height = 8 * gWindows[windowId].window.height;
 
     BlitBitmapRect4Bit(&sourceRect, &destRect, srcX, srcY, destX, destY, rectWidth, rectHeight, 0);
+    MarkWindowDirty(windowId, destX, destY, rectWidth, rectHeight);
 }
 
 static void UNUSED BlitBitmapRectToWindowWithColorKey(u32 windowId, const u8 *pixels, u16 srcX, u16 srcY, u16 srcWidth, int srcHeight, u16 destX, u16 destY, u16 rectWidth, u16 rectHeight, u8 colorKey)
@@ -425,6 +491,7 @@ static void UNUSED BlitBitmapRectToWindowWithColorKey(u32 windowId, const u8 *pi
     destRect.height = 8 * gWindows[windowId].window.height;
 
     BlitBitmapRect4Bit(&sourceRect, &destRect, srcX, srcY, destX, destY, rectWidth, rectHeight, colorKey);
+    MarkWindowDirty(windowId, destX, destY, rectWidth, rectHeight);
 }
 
 void FillWindowPixelRect(u32 windowId, u8 fillValue, u16 x, u16 y, u16 width, u16 height)
@@ -436,6 +503,7 @@ void FillWindowPixelRect(u32 windowId, u8 fillValue, u16 x, u16 y, u16 width, u1
     pixelRect.height = 8 * gWindows[windowId].window.height;
 
     FillBitmapRect4Bit(&pixelRect, x, y, width, height, fillValue);
+    MarkWindowDirty(windowId, x, y, width, height);
 }
 
 void CopyToWindowPixelBuffer(u32 windowId, const void *src, u16 size, u16 tileOffset)
@@ -444,6 +512,7 @@ void CopyToWindowPixelBuffer(u32 windowId, const void *src, u16 size, u16 tileOf
         CpuCopy16(src, gWindows[windowId].tileData + (32 * tileOffset), size);
     else
         LZ77UnCompWram(src, gWindows[windowId].tileData + (32 * tileOffset));
+    MarkWindowAllDirty(windowId);
 }
 
 // Sets all pixels within the window to the fillValue color.
@@ -451,6 +520,7 @@ void FillWindowPixelBuffer(u32 windowId, u8 fillValue)
 {
     int fillSize = gWindows[windowId].window.width * gWindows[windowId].window.height;
     CpuFastFill8(fillValue, gWindows[windowId].tileData, 32 * fillSize);
+    MarkWindowAllDirty(windowId);
 }
 
 #define MOVE_TILES_DOWN(a)                                                      \
@@ -486,6 +556,7 @@ void ScrollWindow(u32 windowId, u8 direction, u8 distance, u8 fillValue)
     s32 srcOffset, destOffset;
     u32 distanceLoop;
 
+    MarkWindowAllDirty(windowId);
     switch (direction)
     {
     case 0:
@@ -543,9 +614,11 @@ bool32 SetWindowAttribute(u32 windowId, u32 attributeId, u32 value)
         return FALSE;
     case WINDOW_BASE_BLOCK:
         gWindows[windowId].window.baseBlock = value;
+        MarkWindowAllDirty(windowId);
         return FALSE;
     case WINDOW_TILE_DATA:
         gWindows[windowId].tileData = (u8 *)(value);
+        MarkWindowAllDirty(windowId);
         return TRUE;
     case WINDOW_BG:
     case WINDOW_WIDTH:
@@ -574,6 +647,8 @@ u32 GetWindowAttribute(u32 windowId, u32 attributeId)
     case WINDOW_BASE_BLOCK:
         return gWindows[windowId].window.baseBlock;
     case WINDOW_TILE_DATA:
+        // The caller may draw to the tiles.
+        MarkWindowAllDirty(windowId);
         return (u32)(gWindows[windowId].tileData);
     default:
         return 0;
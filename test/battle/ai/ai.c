@@ -831,3 +831,27 @@ AI_SINGLE_BATTLE_TEST("AI stays choice locked into moves in spite of the player'
         TURN { EXPECT_MOVE(opponent, aiMove); }
     }
 }
+
+AI_SINGLE_BATTLE_TEST("AI_CalcDamage benchmark")
+{
+    static const u16 moves[] = { MOVE_TACKLE, MOVE_SLASH, MOVE_EMBER, MOVE_SURF };
+    struct Benchmark aiCalcDamage;
+    uq4_12_t effectiveness;
+    u32 j, damage = 0;
+
+    GIVEN {
+        AI_FLAGS(AI_FLAG_CHECK_BAD_MOVE | AI_FLAG_CHECK_VIABILITY | AI_FLAG_TRY_TO_FAINT);
+        PLAYER(SPECIES_WOBBUFFET) { Moves(MOVE_CELEBRATE); }
+        OPPONENT(SPECIES_WOBBUFFET) { Moves(MOVE_TACKLE, MOVE_SLASH, MOVE_EMBER, MOVE_SURF); }
+    } WHEN {
+        TURN { MOVE(player, MOVE_CELEBRATE); }
+    } THEN {
+        BENCHMARK(&aiCalcDamage)
+        {
+            for (j = 0; j < ARRAY_COUNT(moves); j++)
+                damage += AI_CalcDamage(moves[j], B_POSITION_OPPONENT_LEFT, B_POSITION_PLAYER_LEFT, &effectiveness, FALSE, AI_GetWeather(), DMG_ROLL_DEFAULT).expected;
+        }
+        EXPECT_NE(damage, 0);
+        EXPECT_BASELINE(aiCalcDamage);
+    }
+}
@@ -25,3 +25,59 @@ SINGLE_BATTLE_TEST("Forced abilities activate on switch-in")
         MESSAGE("Kadabra's Sp. Atk was heightened!");
     }
 }
+
+SINGLE_BATTLE_TEST("PASSES_RANDOMLY with .sequential passes consistent results")
+{
+    PASSES_RANDOMLY(1, 1, .sequential = TRUE);
+    GIVEN {
+        PLAYER(SPECIES_WOBBUFFET);
+        OPPONENT(SPECIES_WOBBUFFET);
+    } WHEN {
+        TURN { MOVE(player, MOVE_CELEBRATE); }
+    } SCENE {
+        ANIMATION(ANIM_TYPE_MOVE, MOVE_CELEBRATE, player);
+    }
+}
+
+SINGLE_BATTLE_TEST("PASSES_RANDOMLY with .sequential fails inconsistent results")
+{
+    KNOWN_FAILING;
+    PASSES_RANDOMLY(0, 1, .sequential = TRUE);
+    GIVEN {
+        PLAYER(SPECIES_WOBBUFFET);
+        OPPONENT(SPECIES_WOBBUFFET);
+    } WHEN {
+        TURN { MOVE(player, MOVE_CELEBRATE); }
+    } SCENE {
+        ANIMATION(ANIM_TYPE_MOVE, MOVE_CELEBRATE, player);
+    }
+}
+
+SINGLE_BATTLE_TEST("PASSES_RANDOMLY with .sequential stops early on a random effect")
+{
+    PASSES_RANDOMLY(1, 2, .sequential = TRUE, .alpha = Q_4_12(0.01), .delta = Q_4_12(0.4), .maxTrials = 25);
+    GIVEN {
+        ASSUME(GetMoveAccuracy(MOVE_ZAP_CANNON) == 50);
+        PLAYER(SPECIES_WOBBUFFET);
+        OPPONENT(SPECIES_WOBBUFFET);
+    } WHEN {
+        TURN { MOVE(player, MOVE_ZAP_CANNON); MOVE(opponent, MOVE_CELEBRATE); }
+    } SCENE {
+        ANIMATION(ANIM_TYPE_MOVE, MOVE_ZAP_CANNON, player);
+    }
+}
+
+SINGLE_BATTLE_TEST("PASSES_RANDOMLY with .sequential fails if inconclusive after .maxTrials")
+{
+    KNOWN_FAILING;
+    PASSES_RANDOMLY(1, 2, .sequential = TRUE, .delta = Q_4_12(0.05), .maxTrials = 2);
+    GIVEN {
+        ASSUME(GetMoveAccuracy(MOVE_ZAP_CANNON) == 50);
+        PLAYER(SPECIES_WOBBUFFET);
+        OPPONENT(SPECIES_WOBBUFFET);
+    } WHEN {
+        TURN { MOVE(player, MOVE_ZAP_CANNON); MOVE(opponent, MOVE_CELEBRATE); }
+    } SCENE {
+        ANIMATION(ANIM_TYPE_MOVE, MOVE_ZAP_CANNON, player);
+    }
+}
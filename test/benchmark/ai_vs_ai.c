@@ -0,0 +1,62 @@
+#include "global.h"
+#include "test/battle.h"
+
+// Too slow for `make check`, run with `make ai-benchmark`.
+
+static const u16 sAIVsAITrainers[] =
+{
+    TRAINER_LEADER_BROCK,
+    TRAINER_LEADER_MISTY,
+    TRAINER_LEADER_ERIKA,
+    TRAINER_LEADER_SABRINA,
+    TRAINER_ELITE_FOUR_LORELEI,
+    TRAINER_ELITE_FOUR_BRUNO,
+    TRAINER_ELITE_FOUR_AGATHA,
+    TRAINER_ELITE_FOUR_LANCE,
+};
+
+#define AI_VS_AI_FLAGS (AI_FLAG_CHECK_BAD_MOVE | AI_FLAG_CHECK_VIABILITY | AI_FLAG_TRY_TO_FAINT | AI_FLAG_SMART_SWITCHING)
+
+AI_SINGLE_BATTLE_TEST("AI_VS_AI: Kanto Gym Leaders and Elite Four singles")
+{
+    u32 j, k, playerTrainer = TRAINER_NONE, opponentTrainer = TRAINER_NONE;
+    for (j = 0; j < ARRAY_COUNT(sAIVsAITrainers); j++)
+    {
+        for (k = 0; k < ARRAY_COUNT(sAIVsAITrainers); k++)
+        {
+            if (j != k)
+                PARAMETRIZE { playerTrainer = sAIVsAITrainers[j]; opponentTrainer = sAIVsAITrainers[k]; }
+        }
+    }
+    PASSES_RANDOMLY(100, 100);
+    GIVEN {
+        AI_VS_AI;
+        AI_FLAGS(AI_VS_AI_FLAGS);
+        PLAYER_TRAINER_PARTY(playerTrainer);
+        OPPONENT_TRAINER_PARTY(opponentTrainer);
+    } THEN {
+        EXPECT_NE(gBattleOutcome, 0);
+    }
+}
+
+AI_DOUBLE_BATTLE_TEST("AI_VS_AI: Kanto Gym Leaders and Elite Four doubles")
+{
+    u32 j, k, playerTrainer = TRAINER_NONE, opponentTrainer = TRAINER_NONE;
+    for (j = 0; j < ARRAY_COUNT(sAIVsAITrainers); j++)
+    {
+        for (k = 0; k < ARRAY_COUNT(sAIVsAITrainers); k++)
+        {
+            if (j != k)
+                PARAMETRIZE { playerTrainer = sAIVsAITrainers[j]; opponentTrainer = sAIVsAITrainers[k]; }
+        }
+    }
+    PASSES_RANDOMLY(100, 100);
+    GIVEN {
+        AI_VS_AI;
+        AI_FLAGS(AI_VS_AI_FLAGS);
+        PLAYER_TRAINER_PARTY(playerTrainer);
+        OPPONENT_TRAINER_PARTY(opponentTrainer);
+    } THEN {
+        EXPECT_NE(gBattleOutcome, 0);
+    }
+}
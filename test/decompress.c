@@ -0,0 +1,90 @@
+#include "global.h"
+#include "decompress.h"
+#include "malloc.h"
+#include "test/test.h"
+
+static const u32 sBackPicLZ[] = INCBIN_U32("graphics/pokemon/bulbasaur/back.4bpp.lz");
+static const u32 sBackPicFastLZ[] = INCBIN_U32("graphics/pokemon/bulbasaur/back.4bpp.flz");
+
+static u32 sCallbackSize;
+
+static void AsyncDecompressCallback_SaveSize(void *dest, u32 size)
+{
+    sCallbackSize = size;
+}
+
+TEST("RunAsyncDecompression matches LZ77UnCompWram")
+{
+    const u32 *src = gSpeciesInfo[SPECIES_BULBASAUR].frontPic;
+    u32 size = GetDecompressedDataSize(src);
+    u8 *expected = Alloc(size);
+    u8 *actual = Alloc(size);
+    u32 frames = 0;
+
+    LZ77UnCompWram(src, expected);
+    sCallbackSize = 0;
+    RequestAsyncLZDecompressWram(src, actual, AsyncDecompressCallback_SaveSize);
+    while (IsAsyncDecompressionActive())
+    {
+        RunAsyncDecompression(257);
+        frames++;
+    }
+
+    EXPECT_EQ(frames, (size + 256) / 257);
+    EXPECT_EQ(sCallbackSize, size);
+    EXPECT_EQ(memcmp(expected, actual, size), 0);
+    Free(expected);
+    Free(actual);
+}
+
+TEST("RunAsyncDecompression writes VRAM a halfword at a time")
+{
+    const u32 *src = gSpeciesInfo[SPECIES_BULBASAUR].backPic;
+    u32 size = GetDecompressedDataSize(src);
+    u8 *expected = Alloc(size);
+    u8 *actual = OBJ_VRAM0;
+
+    LZ77UnCompWram(src, expected);
+    RequestAsyncLZDecompressVram(src, actual, NULL);
+    while (IsAsyncDecompressionActive())
+        RunAsyncDecompression(33);
+
+    EXPECT_EQ(memcmp(expected, actual, size), 0);
+    Free(expected);
+}
+
+TEST("FinishAsyncDecompression completes the requests in order")
+{
+    const u32 *src = gSpeciesInfo[SPECIES_BULBASAUR].frontPic;
+    u32 size = GetDecompressedDataSize(src);
+    u8 *expected = Alloc(size);
+    u8 *actual = Alloc(size);
+
+    LZ77UnCompWram(src, expected);
+    sCallbackSize = 0;
+    RequestAsyncLZDecompressWram(gSpeciesInfo[SPECIES_IVYSAUR].frontPic, actual, NULL);
+    RequestAsyncLZDecompressWram(src, actual, AsyncDecompressCallback_SaveSize);
+    FinishAsyncDecompression();
+
+    EXPECT(!IsAsyncDecompressionActive());
+    EXPECT_EQ(sCallbackSize, size);
+    EXPECT_EQ(memcmp(expected, actual, size), 0);
+    Free(expected);
+    Free(actual);
+}
+
+TEST("LZDecompressWram decompresses fast LZ data")
+{
+    u32 size = GetDecompressedDataSize(sBackPicLZ);
+    u8 *expected = Alloc(size);
+    u8 *actual = Alloc(size);
+
+    EXPECT_EQ(IsCompressedData(sBackPicFastLZ, size, size), size);
+    EXPECT_EQ(IsLZ77Data(sBackPicFastLZ, size, size), 0);
+    LZ77UnCompWram(sBackPicLZ, expected);
+    LZDecompressWram(sBackPicFastLZ, actual);
+
+    EXPECT_EQ(memcmp(expected, actual, size), 0);
+    Free(expected);
+    Free(actual);
+}
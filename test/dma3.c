@@ -0,0 +1,113 @@
+#include "global.h"
+#include "dma3.h"
+#include "malloc.h"
+#include "test/test.h"
+
+static const u8 sSrc[0x400] = {0};
+
+TEST("RequestDma3Copy merges contiguous copies")
+{
+    u8 *dest = OBJ_VRAM0;
+    s16 index;
+    ClearDma3Requests();
+    index = RequestDma3Copy(sSrc, dest, 0x100, DMA3_32BIT);
+    EXPECT_EQ(RequestDma3Copy(sSrc + 0x100, dest + 0x100, 0x100, DMA3_32BIT), index);
+    EXPECT_EQ(RequestDma3Copy(sSrc + 0x80, dest + 0x80, 0x200, DMA3_32BIT), index);
+    EXPECT_NE(RequestDma3Copy(sSrc + 0x300, dest + 0x300, 0x100, DMA3_16BIT), index);
+    ClearDma3Requests();
+}
+
+TEST("RequestDma3Copy replaces a copy to the same destination")
+{
+    u8 *dest = OBJ_VRAM0;
+    s16 index;
+    ClearDma3Requests();
+    index = RequestDma3Copy(sSrc, dest, 0x100, DMA3_32BIT);
+    EXPECT_EQ(RequestDma3Copy(sSrc + 0x200, dest, 0x100, DMA3_32BIT), index);
+    ClearDma3Requests();
+}
+
+TEST("RequestDma3Fill merges fills of the same value")
+{
+    u8 *dest = OBJ_VRAM0;
+    s16 index;
+    ClearDma3Requests();
+    index = RequestDma3Fill(0, dest, 0x100, DMA3_32BIT);
+    EXPECT_EQ(RequestDma3Fill(0, dest + 0x100, 0x100, DMA3_32BIT), index);
+    EXPECT_NE(RequestDma3Fill(1, dest + 0x200, 0x100, DMA3_32BIT), index);
+    ClearDma3Requests();
+}
+
+TEST("RequestDma3Copy does not merge past a request to the same destination")
+{
+    u8 *dest = OBJ_VRAM0;
+    s16 index;
+    ClearDma3Requests();
+    index = RequestDma3Copy(sSrc, dest, 0x100, DMA3_32BIT);
+    RequestDma3Fill(0, dest + 0x100, 0x100, DMA3_32BIT);
+    EXPECT_NE(RequestDma3Copy(sSrc + 0x100, dest + 0x100, 0x100, DMA3_32BIT), index);
+    ClearDma3Requests();
+}
+
+// Processes the requests early in a frame, so that none are deferred for
+// running out of v-blank. Interrupts must be off, so that the v-blank
+// handler does not process them first.
+static void ProcessDma3RequestsInFrame(void)
+{
+    while (REG_VCOUNT >= DISPLAY_HEIGHT)
+        ;
+    ProcessDma3Requests();
+}
+
+TEST("ProcessDma3Requests copies palettes before VRAM and defers past 40 KiB")
+{
+    u16 ime = REG_IME;
+    s16 tiles, moreTiles, palettes;
+    bool32 palettesDone, tilesDone, moreTilesDeferred, moreTilesDone;
+
+    REG_IME = 0;
+    ClearDma3Requests();
+    tiles = RequestDma3Copy((const void *)ROM_START, (void *)BG_VRAM, 0x8000, DMA3_32BIT);
+    moreTiles = RequestDma3Copy((const void *)(ROM_START + 0x10000), (void *)(BG_VRAM + 0x8000), 0x2000, DMA3_32BIT);
+    palettes = RequestDma3Fill(0x7FFF7FFF, (void *)PLTT, PLTT_SIZE, DMA3_32BIT);
+    ProcessDma3RequestsInFrame();
+    palettesDone = WaitDma3Request(palettes) == 0;
+    tilesDone = WaitDma3Request(tiles) == 0;
+    moreTilesDeferred = WaitDma3Request(moreTiles) == -1;
+    ProcessDma3RequestsInFrame();
+    moreTilesDone = WaitDma3Request(-1) == 0;
+    REG_IME = ime;
+
+    EXPECT(palettesDone);
+    EXPECT(tilesDone);
+    EXPECT(moreTilesDeferred);
+    EXPECT(moreTilesDone);
+    EXPECT_EQ(((u16 *)PLTT)[0], 0x7FFF);
+    EXPECT_EQ(((u16 *)PLTT)[PLTT_SIZE / 2 - 1], 0x7FFF);
+}
+
+TEST("ProcessDma3Requests does not run a palette copy before a write to its source")
+{
+    u16 ime = REG_IME;
+    u32 i;
+    u16 *staged = Alloc(PLTT_SIZE);
+    u16 *colors = Alloc(PLTT_SIZE);
+
+    for (i = 0; i < PLTT_SIZE / 2; i++)
+    {
+        staged[i] = 0;
+        colors[i] = i;
+    }
+
+    REG_IME = 0;
+    ClearDma3Requests();
+    RequestDma3Copy(colors, staged, PLTT_SIZE, DMA3_32BIT);
+    RequestDma3Copy(staged, (void *)PLTT, PLTT_SIZE, DMA3_32BIT);
+    ProcessDma3RequestsInFrame();
+    REG_IME = ime;
+
+    for (i = 0; i < PLTT_SIZE / 2; i++)
+        EXPECT_EQ(((u16 *)PLTT)[i], i);
+    Free(staged);
+    Free(colors);
+}
@@ -0,0 +1,100 @@
+#include "global.h"
+#include "malloc.h"
+#include "test/test.h"
+
+static u32 LargestFreeBlock(void)
+{
+    u32 largest = 0;
+    const struct MemBlock *head = HeapHead();
+    const struct MemBlock *block = head;
+    do
+    {
+        if (!block->allocated && largest < block->size)
+            largest = block->size;
+        block = block->next;
+    } while (block != head);
+    return largest;
+}
+
+TEST("Alloc reuses a freed block of the same size")
+{
+    void *a = Alloc(100);
+    void *b = Alloc(100);
+    void *c = Alloc(100);
+    Free(b);
+    EXPECT_EQ(Alloc(100), b);
+    Free(a);
+    Free(b);
+    Free(c);
+}
+
+TEST("Alloc fits small blocks in gaps")
+{
+    u32 i;
+    void *blocks[8];
+    void *small;
+
+    for (i = 0; i < ARRAY_COUNT(blocks); i++)
+        blocks[i] = Alloc(64);
+    Free(blocks[3]);
+    small = Alloc(16);
+    EXPECT_GE((uintptr_t)small, (uintptr_t)blocks[3]);
+    EXPECT_LT((uintptr_t)small, (uintptr_t)blocks[4]);
+    Free(small);
+    for (i = 0; i < ARRAY_COUNT(blocks); i++)
+    {
+        if (i != 3)
+            Free(blocks[i]);
+    }
+}
+
+TEST("Free merges neighboring free blocks")
+{
+    u32 largest = LargestFreeBlock();
+    void *a = Alloc(100);
+    void *b = Alloc(200);
+    void *c = Alloc(300);
+    Free(b);
+    Free(a);
+    Free(c);
+    EXPECT_EQ(LargestFreeBlock(), largest);
+    EXPECT(CheckHeap());
+}
+
+TEST("FreeHeapArena frees only the blocks allocated in the arena")
+{
+    u32 largest = LargestFreeBlock();
+    u32 arena;
+    void *outer = Alloc(100);
+
+    arena = PushHeapArena();
+    Alloc(100);
+    AllocZeroed(200);
+    Alloc(4);
+    FreeHeapArena(arena);
+
+    EXPECT(CheckHeap());
+    EXPECT(((const struct MemBlock *)outer - 1)->allocated);
+    Free(outer);
+    EXPECT_EQ(LargestFreeBlock(), largest);
+}
+
+TEST("FreeHeapArena frees the arenas nested in it")
+{
+    u32 largest = LargestFreeBlock();
+    u32 outer, inner;
+    void *kept;
+
+    outer = PushHeapArena();
+    Alloc(100);
+    inner = PushHeapArena();
+    Alloc(100);
+    FreeHeapArena(inner);
+    Alloc(100);
+    FreeHeapArena(outer);
+
+    kept = Alloc(100);
+    EXPECT(((const struct MemBlock *)kept - 1)->arena == 0);
+    Free(kept);
+    EXPECT_EQ(LargestFreeBlock(), largest);
+}
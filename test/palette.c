@@ -0,0 +1,76 @@
+#include "global.h"
+#include "malloc.h"
+#include "palette.h"
+#include "random.h"
+#include "util.h"
+#include "constants/rgb.h"
+#include "test/test.h"
+
+// BlendPalette as it was before the blend tables, to compare against.
+static void BlendPaletteReference(u16 palOffset, u16 numEntries, u8 coeff, u32 blendColor)
+{
+    u16 i;
+    for (i = 0; i < numEntries; i++)
+    {
+        u16 index = i + palOffset;
+        struct PlttData *data1 = (struct PlttData *)&gPlttBufferUnfaded[index];
+        s8 r = data1->r;
+        s8 g = data1->g;
+        s8 b = data1->b;
+        struct PlttData *data2 = (struct PlttData *)&blendColor;
+        gPlttBufferFaded[index] = ((r + (((data2->r - r) * coeff) >> 4)) << 0)
+                                | ((g + (((data2->g - g) * coeff) >> 4)) << 5)
+                                | ((b + (((data2->b - b) * coeff) >> 4)) << 10);
+    }
+}
+
+static void BlendPalettesReference(u32 selectedPalettes, u8 coeff, u32 color)
+{
+    u16 paletteOffset;
+
+    for (paletteOffset = 0; selectedPalettes; paletteOffset += 16)
+    {
+        if (selectedPalettes & 1)
+            BlendPaletteReference(paletteOffset, 16, coeff, color);
+        selectedPalettes >>= 1;
+    }
+}
+
+static void FillRandomPalettes(void)
+{
+    u32 i;
+    for (i = 0; i < PLTT_BUFFER_SIZE; i++)
+        gPlttBufferUnfaded[i] = Random() & 0x7FFF;
+}
+
+TEST("BlendPalettes is faster than blending each color (all palettes)")
+{
+    struct Benchmark reference, blendPalettes;
+    u16 *expected = Alloc(PLTT_SIZE);
+
+    FillRandomPalettes();
+    BENCHMARK(&reference) { BlendPalettesReference(PALETTES_ALL, 9, RGB_BLACK); }
+    CpuCopy16(gPlttBufferFaded, expected, PLTT_SIZE);
+    BENCHMARK(&blendPalettes) { BlendPalettes(PALETTES_ALL, 9, RGB_BLACK); }
+
+    EXPECT_EQ(memcmp(expected, gPlttBufferFaded, PLTT_SIZE), 0);
+    EXPECT_FASTER(blendPalettes, reference);
+    EXPECT_BASELINE(blendPalettes);
+    Free(expected);
+}
+
+TEST("BlendPalettes matches blending each color at every coefficient")
+{
+    u32 coeff;
+    u16 *expected = Alloc(PLTT_SIZE);
+
+    FillRandomPalettes();
+    for (coeff = 0; coeff <= 16; coeff++)
+    {
+        BlendPalettesReference(PALETTES_BG, coeff, RGB(31, 12, 5));
+        CpuCopy16(gPlttBufferFaded, expected, PLTT_SIZE);
+        BlendPalettes(PALETTES_BG, coeff, RGB(31, 12, 5));
+        EXPECT_EQ(memcmp(expected, gPlttBufferFaded, PLTT_SIZE), 0);
+    }
+    Free(expected);
+}
@@ -422,3 +422,23 @@ TEST("Pokémon level up learnsets fit within MAX_LEVEL_UP_MOVES and MAX_RELEARNE
     EXPECT_LT(count, MAX_LEVEL_UP_MOVES);
     EXPECT_LT(count, MAX_RELEARNER_MOVES - 1); // - 1 because at least one move is already known
 }
+
+TEST("GetBoxMonData benchmark")
+{
+    static const u16 fields[] = { MON_DATA_SPECIES, MON_DATA_HELD_ITEM, MON_DATA_EXP, MON_DATA_FRIENDSHIP, MON_DATA_MOVE1, MON_DATA_PP1, MON_DATA_HP_EV, MON_DATA_ATK_IV };
+    struct Benchmark getBoxMonData;
+    struct Pokemon mon;
+    u32 i, j, sum = 0;
+
+    CreateMon(&mon, SPECIES_WOBBUFFET, 100, 0, FALSE, 0, OT_ID_PRESET, 0);
+    BENCHMARK(&getBoxMonData)
+    {
+        for (i = 0; i < 16; i++)
+        {
+            for (j = 0; j < ARRAY_COUNT(fields); j++)
+                sum += GetBoxMonData(&mon.box, fields[j]);
+        }
+    }
+    EXPECT_NE(sum, 0);
+    EXPECT_BASELINE(getBoxMonData);
+}
@@ -69,6 +69,7 @@ static void BenchmarkBuildOamBuffer(bool32 preSort)
 
     ExpectEqOamBuffers(oldOamBuffer, gMain.oamBuffer);
     EXPECT_FASTER(newBuildOamBuffer, oldBuildOamBuffer);
+    EXPECT_BASELINE(newBuildOamBuffer);
     Free(oldOamBuffer);
 }
 
@@ -121,6 +122,114 @@ TEST("BuildOamBuffer faster with mix of sprites")
     BenchmarkBuildOamBuffer(FALSE);
 }
 
+TEST("CreateSprite reuses a sprite freed by clearing inUse")
+{
+    u32 a, b;
+    ResetSpriteData_();
+    a = CreateSprite(&gDummySpriteTemplate, 0, 0, 0);
+    b = CreateSprite(&gDummySpriteTemplate, 0, 0, 0);
+    gSprites[a].inUse = FALSE;
+    EXPECT_EQ(CreateSprite(&gDummySpriteTemplate, 0, 0, 0), a);
+    EXPECT_EQ(CreateSpriteAtEnd(&gDummySpriteTemplate, 0, 0, 0), MAX_SPRITES - 1);
+    EXPECT_EQ(CreateSprite(&gDummySpriteTemplate, 0, 0, 0), b + 1);
+}
+
+static void SpriteCallback_CountCalls(struct Sprite *sprite)
+{
+    sprite->data[0]++;
+}
+
+static void SpriteCallback_CreateSprite(struct Sprite *sprite)
+{
+    struct SpriteTemplate template = gDummySpriteTemplate;
+    template.oam = &gDummyOamData;
+    template.anims = gDummySpriteAnimTable;
+    template.affineAnims = gDummySpriteAffineAnimTable;
+    template.callback = SpriteCallback_CountCalls;
+    if (sprite->data[0]++ == 0)
+        sprite->data[1] = CreateSprite(&template, 0, 0, 0);
+}
+
+TEST("AnimateSprites runs sprites created by an earlier sprite's callback")
+{
+    u32 spriteId, childId;
+    struct SpriteTemplate template = gDummySpriteTemplate;
+    template.oam = &gDummyOamData;
+    template.anims = gDummySpriteAnimTable;
+    template.affineAnims = gDummySpriteAffineAnimTable;
+    template.callback = SpriteCallback_CreateSprite;
+    ResetSpriteData_();
+    spriteId = CreateSprite(&template, 0, 0, 0);
+    AnimateSprites();
+    childId = gSprites[spriteId].data[1];
+    EXPECT_EQ(gSprites[spriteId].data[0], 1);
+    EXPECT_GT(childId, spriteId);
+    EXPECT_EQ(gSprites[childId].data[0], 1);
+    DestroySprite(&gSprites[spriteId]);
+    AnimateSprites();
+    EXPECT_EQ(gSprites[childId].data[0], 2);
+}
+
+static u32 CountOamEntriesAtX(u32 x)
+{
+    u32 i, count = 0;
+    for (i = 0; i < gOamLimit; i++)
+    {
+        if (gMain.oamBuffer[i].x == x && gMain.oamBuffer[i].y < DISPLAY_HEIGHT)
+            count++;
+    }
+    return count;
+}
+
+TEST("A sprite copied into a free slot is animated and drawn")
+{
+    u32 spriteId, copyId, unmarkedId;
+    struct SpriteTemplate template = gDummySpriteTemplate;
+    template.oam = &gDummyOamData;
+    template.anims = gDummySpriteAnimTable;
+    template.affineAnims = gDummySpriteAffineAnimTable;
+    template.callback = SpriteCallback_CountCalls;
+    ResetSpriteData_();
+    spriteId = CreateSprite(&template, 40, 50, 0);
+
+    // As CloneBattlerSpriteWithBlend does.
+    copyId = spriteId + 1;
+    gSprites[copyId] = gSprites[spriteId];
+    MarkSpriteInUse(copyId);
+    gSprites[copyId].x = 80;
+
+    // Copied without MarkSpriteInUse, which is not animated but is
+    // still drawn.
+    unmarkedId = spriteId + 2;
+    gSprites[unmarkedId] = gSprites[spriteId];
+    gSprites[unmarkedId].x = 120;
+
+    AnimateSprites();
+    BuildOamBuffer();
+    EXPECT_EQ(gSprites[spriteId].data[0], 1);
+    EXPECT_EQ(gSprites[copyId].data[0], 1);
+    EXPECT_EQ(CountOamEntriesAtX(gSprites[spriteId].oam.x), 1);
+    EXPECT_EQ(CountOamEntriesAtX(gSprites[copyId].oam.x), 1);
+    EXPECT_EQ(CountOamEntriesAtX(gSprites[unmarkedId].oam.x), 1);
+}
+
+TEST("AllocSpriteTiles allocates the first run of free tiles which fits")
+{
+    u32 i;
+    ResetSpriteData_();
+    EXPECT_EQ(AllocSpriteTiles(30), 0);
+    EXPECT_EQ(AllocSpriteTiles(40), 30);
+    EXPECT_EQ(AllocSpriteTiles(8), 70);
+    for (i = 33; i < 37; i++)
+        SpriteTileAllocBitmapOp(i, 0);
+    EXPECT_EQ(AllocSpriteTiles(5), 78);
+    EXPECT_EQ(AllocSpriteTiles(4), 33);
+    EXPECT_EQ(AllocSpriteTiles(TOTAL_OBJ_TILE_COUNT - 83), 83);
+    EXPECT_EQ(AllocSpriteTiles(1), -1);
+    AllocSpriteTiles(0);
+    EXPECT_EQ(AllocSpriteTiles(TOTAL_OBJ_TILE_COUNT), 0);
+}
+
 // Old implementation.
 
 #define UBFIX
@@ -25,6 +25,7 @@ enum {
 __attribute__((section(".persistent"))) static struct {
     u32 address:28;
     u32 state:1;
+    u16 shard;
 } sCurrentTest = {0};
 
 void TestRunner_Battle(const struct Test *);
@@ -53,6 +54,40 @@ static bool32 PrefixMatch(const char *pattern, const char *string)
     }
 }
 
+// Matches if any of the space-separated patterns is a prefix of filename.
+static bool32 FilenameMatch(const char *patterns, const char *filename)
+{
+    const char *string;
+
+    if (!*patterns)
+        return TRUE;
+
+    while (*patterns)
+    {
+        string = filename;
+        while (*patterns && *patterns != ' ' && *patterns == *string)
+        {
+            patterns++;
+            string++;
+        }
+        if (!*patterns || *patterns == ' ')
+            return TRUE;
+        while (*patterns && *patterns != ' ')
+            patterns++;
+        while (*patterns == ' ')
+            patterns++;
+    }
+
+    return FALSE;
+}
+
+static bool32 ShouldRunTest(const struct Test *test)
+{
+    return test->runner == &gAssumptionsRunner
+        || (PrefixMatch(gTestRunnerArgv, test->name)
+         && FilenameMatch(gTestRunnerFiles, test->filename));
+}
+
 enum
 {
     STATE_INIT,
@@ -82,25 +117,45 @@ static u32 MinCostProcess(void)
     return minCostProcess;
 }
 
-// Greedily assign tests to processes based on estimated cost.
+// Greedily assign test shards to processes based on estimated cost.
+// The test is estimated when assigning its first shard, and its cost
+// is split evenly between its shards.
 // TODO: Make processCosts a min heap.
 static u32 AssignCostToRunner(void)
 {
     u32 minCostProcess;
 
-    if (gTestRunnerState.test->runner == &gAssumptionsRunner)
-        return gTestRunnerI;
+    if (gTestRunnerState.shard == 0)
+    {
+        u32 cost;
 
-    minCostProcess = MinCostProcess();
+        gTestRunnerState.shardsCount = 1;
+        gTestRunnerState.shardCost = 1;
+        if (gTestRunnerState.test->runner == &gAssumptionsRunner)
+            return gTestRunnerI;
 
-    // XXX: If estimateCost returns only on some processes, or
-    // returns inconsistent results then processCosts will be
-    // inconsistent and some tests may not run.
-    if (gTestRunnerState.test->runner->estimateCost)
-        gTestRunnerState.processCosts[minCostProcess] += gTestRunnerState.test->runner->estimateCost(gTestRunnerState.test->data);
-    else
-        gTestRunnerState.processCosts[minCostProcess] += 1;
+        // XXX: If estimateCost or estimateShards returns only on some
+        // processes, or returns inconsistent results then processCosts
+        // will be inconsistent and some tests may not run.
+        if (gTestRunnerState.test->runner->estimateCost)
+            cost = gTestRunnerState.test->runner->estimateCost(gTestRunnerState.test->data);
+        else
+            cost = 1;
+
+        // Splitting a test only helps if there are other processes to
+        // run the shards.
+        if (gTestRunnerN > 1 && gTestRunnerState.test->runner->estimateShards)
+        {
+            gTestRunnerState.shardsCount = gTestRunnerState.test->runner->estimateShards(gTestRunnerState.test->data);
+            if (gTestRunnerState.shardsCount == 0)
+                gTestRunnerState.shardsCount = 1;
+        }
 
+        gTestRunnerState.shardCost = max(1, cost / gTestRunnerState.shardsCount);
+    }
+
+    minCostProcess = MinCostProcess();
+    gTestRunnerState.processCosts[minCostProcess] += gTestRunnerState.shardCost;
     return minCostProcess;
 }
 
@@ -131,14 +186,23 @@ top:
         if (sCurrentTest.address != 0)
         {
             gTestRunnerState.test = __start_tests;
+            gTestRunnerState.shard = 0;
             while ((uintptr_t)gTestRunnerState.test != sCurrentTest.address)
             {
-                AssignCostToRunner();
+                if (ShouldRunTest(gTestRunnerState.test))
+                {
+                    do
+                    {
+                        AssignCostToRunner();
+                    } while (++gTestRunnerState.shard < gTestRunnerState.shardsCount);
+                    gTestRunnerState.shard = 0;
+                }
                 gTestRunnerState.test++;
             }
             if (sCurrentTest.state == CURRENT_TEST_STATE_ESTIMATE)
             {
                 u32 runner = MinCostProcess();
+                gTestRunnerState.shardsCount = 1;
                 gTestRunnerState.processCosts[runner] += 1;
                 if (runner == gTestRunnerI)
                 {
@@ -152,6 +216,15 @@ top:
             }
             else
             {
+                // Replay the assignment of the crashed shard and the
+                // shards before it.
+                while (TRUE)
+                {
+                    AssignCostToRunner();
+                    if (gTestRunnerState.shard == sCurrentTest.shard)
+                        break;
+                    gTestRunnerState.shard++;
+                }
                 gTestRunnerState.state = STATE_REPORT_RESULT;
                 gTestRunnerState.result = TEST_RESULT_CRASH;
             }
@@ -160,6 +233,7 @@ top:
         {
             gTestRunnerState.state = STATE_ASSIGN_TEST;
             gTestRunnerState.test = __start_tests;
+            gTestRunnerState.shard = 0;
         }
         gTestRunnerState.exitCode = 0;
         gTestRunnerState.skipFilename = NULL;
@@ -174,15 +248,14 @@ top:
                 gTestRunnerState.state = STATE_EXIT;
                 return;
             }
-            if (gTestRunnerState.test->runner != &gAssumptionsRunner
-              && !PrefixMatch(gTestRunnerArgv, gTestRunnerState.test->name))
+            if (!ShouldRunTest(gTestRunnerState.test))
                 ++gTestRunnerState.test;
             else
                 break;
         }
 
         Test_MgbaPrintf(":N%s", gTestRunnerState.test->name);
-        Test_MgbaPrintf(":L%s:%d", gTestRunnerState.test->filename);
+        Test_MgbaPrintf(":L%s:%d", gTestRunnerState.test->filename, gTestRunnerState.test->sourceLine);
         gTestRunnerState.result = TEST_RESULT_PASS;
         gTestRunnerState.expectedResult = TEST_RESULT_PASS;
         gTestRunnerState.expectLeaks = FALSE;
@@ -198,6 +271,7 @@ top:
 
         sCurrentTest.address = (uintptr_t)gTestRunnerState.test;
         sCurrentTest.state = CURRENT_TEST_STATE_ESTIMATE;
+        sCurrentTest.shard = gTestRunnerState.shard;
 
         // If AssignCostToRunner fails, we want to report the failure.
         gTestRunnerState.state = STATE_REPORT_RESULT;
@@ -211,6 +285,11 @@ top:
     case STATE_RUN_TEST:
         gTestRunnerState.state = STATE_REPORT_RESULT;
         sCurrentTest.state = CURRENT_TEST_STATE_RUN;
+        gTestRunnerState.startFrame = gMain.vblankCounter1;
+        if (gTestRunnerState.shardsCount > 1)
+            Test_MgbaPrintf(":S%d/%d", gTestRunnerState.shard, gTestRunnerState.shardsCount);
+        else
+            Test_MgbaPrintf(":S");
         SeedRng(0);
         SeedRng2(0);
         if (gTestRunnerState.test->runner->setUp)
@@ -301,7 +380,10 @@ top:
             }
             else if (gTestRunnerState.result != TEST_RESULT_ASSUMPTION_FAIL || gTestRunnerSkipIsFail)
             {
-                gTestRunnerState.exitCode = 1;
+                // Hydra merges the results of shards, and so decides
+                // whether the test failed.
+                if (gTestRunnerState.shardsCount <= 1 || gTestRunnerState.result == TEST_RESULT_ASSUMPTION_FAIL)
+                    gTestRunnerState.exitCode = 1;
                 color = "\e[31m";
             }
             else
@@ -309,6 +391,8 @@ top:
                 color = "";
             }
 
+            Test_MgbaPrintf(":D%d", gMain.vblankCounter1 - gTestRunnerState.startFrame);
+
             switch (gTestRunnerState.result)
             {
             case TEST_RESULT_FAIL:
@@ -379,7 +463,11 @@ top:
 
     case STATE_NEXT_TEST:
         gTestRunnerState.state = STATE_ASSIGN_TEST;
-        gTestRunnerState.test++;
+        if (++gTestRunnerState.shard >= gTestRunnerState.shardsCount)
+        {
+            gTestRunnerState.shard = 0;
+            gTestRunnerState.test++;
+        }
         break;
 
     case STATE_EXIT:
@@ -6,3 +6,5 @@ const bool8 gTestRunnerEnabled = TRUE;
 const u8 gTestRunnerN = 0;
 const u8 gTestRunnerI = 0;
 const char gTestRunnerArgv[256] = {'\0'};
+// Space-separated filename prefixes, e.g. "test/battle/ai/ test/sprite.c".
+const char gTestRunnerFiles[4096] = {'\0'};
@@ -156,6 +156,29 @@ static u32 BattleTest_EstimateCost(void *data)
     return cost;
 }
 
+static u32 TrialShards(u32 trials)
+{
+    return (trials + BATTLE_TEST_TRIALS_PER_SHARD - 1) / BATTLE_TEST_TRIALS_PER_SHARD;
+}
+
+// Each parameter, and each range of untagged PASSES_RANDOMLY trials,
+// can run in a different process unless FINALLY needs the results of
+// every parameter. Tagged trials cannot be split because their count
+// is not known until the test runs, and sequential trials cannot be
+// split because each decides whether to run the next.
+// Uses the STATE from BattleTest_EstimateCost.
+static u32 BattleTest_EstimateShards(void *data)
+{
+    u32 shards;
+    const struct BattleTest *test = data;
+    if (test->resultsSize > 0)
+        return 1;
+    shards = max(1, STATE->parametersCount);
+    if (STATE->trials > 1 && !STATE->sequential)
+        shards *= TrialShards(STATE->trials);
+    return shards;
+}
+
 static void BattleTest_SetUp(void *data)
 {
     const struct BattleTest *test = data;
@@ -169,6 +192,14 @@ static void BattleTest_SetUp(void *data)
         Test_ExitWithResult(TEST_RESULT_ERROR, SourceLine(0), ":LOOM: STATE (%d) + STATE->results (%d) too big for sBackupMapData (%d)", sizeof(*STATE), test->resultsSize * STATE->parameters, sizeof(sBackupMapData));
     STATE->results = (void *)((char *)sBackupMapData + sizeof(struct BattleTestRunnerState));
     memset(STATE->results, 0, test->resultsSize * STATE->parameters);
+    STATE->parametersEnd = STATE->parameters;
+    if (gTestRunnerState.shardsCount > 1)
+    {
+        STATE->trialShards = gTestRunnerState.shardsCount / max(1, STATE->parameters);
+        STATE->trialShard = gTestRunnerState.shard % STATE->trialShards;
+        STATE->runParameter = gTestRunnerState.shard / STATE->trialShards;
+        STATE->parametersEnd = STATE->runParameter + 1;
+    }
     switch (test->type)
     {
     case BATTLE_TEST_SINGLES:
@@ -331,7 +362,7 @@ static void BattleTest_Run(void *data)
             Test_ExitWithResult(TEST_RESULT_INVALID, SourceLine(0), ":LSpeed required for all PLAYERs and OPPONENTs");
         }
     }
-    else
+    else if (!DATA.aiVsAi)
     {
         SetImplicitSpeeds();
     }
@@ -356,7 +387,8 @@ u32 RandomUniform(enum RandomTag tag, u32 lo, u32 hi)
 {
     const struct BattlerTurn *turn = NULL;
 
-    if (gCurrentTurnActionNumber < gBattlersCount)
+    // AI_VS_AI battles can run past MAX_TURNS.
+    if (gCurrentTurnActionNumber < gBattlersCount && gBattleResults.battleTurnCounter < MAX_TURNS)
     {
         u32 battlerId = gBattlerByTurnOrder[gCurrentTurnActionNumber];
         turn = &DATA.battleRecordTurns[gBattleResults.battleTurnCounter][battlerId];
@@ -389,7 +421,7 @@ u32 RandomUniformExcept(enum RandomTag tag, u32 lo, u32 hi, bool32 (*reject)(u32
     const struct BattlerTurn *turn = NULL;
     u32 default_;
 
-    if (gCurrentTurnActionNumber < gBattlersCount)
+    if (gCurrentTurnActionNumber < gBattlersCount && gBattleResults.battleTurnCounter < MAX_TURNS)
     {
         u32 battlerId = gBattlerByTurnOrder[gCurrentTurnActionNumber];
         turn = &DATA.battleRecordTurns[gBattleResults.battleTurnCounter][battlerId];
@@ -442,7 +474,7 @@ u32 RandomWeightedArray(enum RandomTag tag, u32 sum, u32 n, const u8 *weights)
     if (sum == 0)
         Test_ExitWithResult(TEST_RESULT_ERROR, SourceLine(0), ":LRandomWeightedArray called with zero sum");
 
-    if (gCurrentTurnActionNumber < gBattlersCount)
+    if (gCurrentTurnActionNumber < gBattlersCount && gBattleResults.battleTurnCounter < MAX_TURNS)
     {
         u32 battlerId = gBattlerByTurnOrder[gCurrentTurnActionNumber];
         turn = &DATA.battleRecordTurns[gBattleResults.battleTurnCounter][battlerId];
@@ -506,7 +538,7 @@ const void *RandomElementArray(enum RandomTag tag, const void *array, size_t siz
     const struct BattlerTurn *turn = NULL;
     u32 index = count-1;
 
-    if (gCurrentTurnActionNumber < gBattlersCount)
+    if (gCurrentTurnActionNumber < gBattlersCount && gBattleResults.battleTurnCounter < MAX_TURNS)
     {
         u32 battlerId = gBattlerByTurnOrder[gCurrentTurnActionNumber];
         turn = &DATA.battleRecordTurns[gBattleResults.battleTurnCounter][battlerId];
@@ -999,6 +1031,9 @@ void TestRunner_Battle_CheckAiMoveScores(u32 battlerId)
     const char *filename = gTestRunnerState.test->filename;
     s32 turn = gBattleResults.battleTurnCounter;
 
+    if (turn >= MAX_TURNS)
+        return;
+
     for (i = 0; i < MAX_AI_SCORE_COMPARISION_PER_TURN; i++)
     {
         struct ExpectedAiScore *scoreCtx = &DATA.expectedAiScores[battlerId][turn][i];
@@ -1307,11 +1342,38 @@ static const char *const sEventTypeMacros[] =
     [QUEUED_STATUS_EVENT] = "STATUS_ICON",
 };
 
+static void RecordAIBenchmarkSample(struct AIBenchmarkSamples *samples, u32 value)
+{
+    samples->count++;
+    samples->total += value;
+    if (samples->max < value)
+        samples->max = value;
+    samples->log2Counts[value == 0 ? 0 : 31 - __builtin_clz(value)]++;
+}
+
+static void RecordAIVsAIBattle(void)
+{
+    struct AIBenchmarkStats *stats = &STATE->aiBenchmark;
+
+    stats->battles++;
+    stats->turns[min(gBattleResults.battleTurnCounter + 1, AI_VS_AI_MAX_TURNS)]++;
+    if (DATA.trial.reachedMaxTurns)
+        stats->reachedMaxTurns++;
+    else if (gBattleOutcome == B_OUTCOME_WON)
+        stats->won++;
+    else if (gBattleOutcome == B_OUTCOME_LOST)
+        stats->lost++;
+    else
+        stats->drew++;
+}
+
 void TestRunner_Battle_AfterLastTurn(void)
 {
     const struct BattleTest *test = GetBattleTest();
 
-    if (DATA.turns - 1 != DATA.trial.lastActionTurn)
+    if (DATA.aiVsAi)
+        RecordAIVsAIBattle();
+    else if (DATA.turns - 1 != DATA.trial.lastActionTurn)
     {
         const char *filename = gTestRunnerState.test->filename;
         Test_ExitWithResult(TEST_RESULT_FAIL, SourceLine(0), ":L%s:%d: %d TURNs specified, but %d ran", filename, SourceLine(0), DATA.turns, DATA.trial.lastActionTurn + 1);
@@ -1347,7 +1409,7 @@ static void TearDownBattle(void)
 
 static void CB2_BattleTest_NextParameter(void)
 {
-    if (++STATE->runParameter >= STATE->parameters)
+    if (++STATE->runParameter >= STATE->parametersEnd)
     {
         SetMainCallback2(CB2_TestRunner);
         ClearFlagAfterTest();
@@ -1371,8 +1433,121 @@ static inline rng_value_t MakeRngValue(const u16 seed)
     return result;
 }
 
+static u32 TrialsEnd(void)
+{
+    if (STATE->trialShards > 1)
+        return min(STATE->trials, (STATE->trialShard + 1) * BATTLE_TEST_TRIALS_PER_SHARD);
+    return STATE->trials;
+}
+
+// log2(x / 4096) in 1/65536ths.
+static s32 Log2Q_4_12(u32 x)
+{
+    s32 i, result = 0;
+
+    x <<= 4;
+    while (x < (1 << 16))
+    {
+        x <<= 1;
+        result -= 1 << 16;
+    }
+    while (x >= (2 << 16))
+    {
+        x >>= 1;
+        result += 1 << 16;
+    }
+    for (i = 15; i >= 0; i--)
+    {
+        x = ((u64)x * x) >> 16;
+        if (x >= (2 << 16))
+        {
+            x >>= 1;
+            result += 1 << i;
+        }
+    }
+    return result;
+}
+
+static void InitSequentialTrials(u32 sourceLine, struct RandomlyContext ctx)
+{
+    s32 i;
+    struct SequentialTrials *sequential = &STATE->sequentialTrials;
+    u32 alpha = ctx.alpha ? ctx.alpha : BATTLE_TEST_SEQUENTIAL_ALPHA;
+    u32 beta = ctx.beta ? ctx.beta : BATTLE_TEST_SEQUENTIAL_BETA;
+    u32 delta = ctx.delta ? ctx.delta : BATTLE_TEST_SEQUENTIAL_DELTA;
+    s32 expected = STATE->expectedRatio;
+
+    INVALID_IF(alpha >= Q_4_12(1) || beta >= Q_4_12(1), "alpha and beta must be less than 1");
+    INVALID_IF(delta >= Q_4_12(1), "delta must be less than 1");
+
+    memset(sequential, 0, sizeof(*sequential));
+    sequential->maxTrials = ctx.maxTrials;
+    sequential->acceptBound = Log2Q_4_12(beta) - Log2Q_4_12(Q_4_12(1) - alpha);
+    sequential->rejectBound = Log2Q_4_12(Q_4_12(1) - beta) - Log2Q_4_12(alpha);
+    for (i = 0; i < 2; i++)
+    {
+        s32 alternative = i == 0 ? expected - delta : expected + delta;
+        if (alternative <= 0 || alternative >= Q_4_12(1))
+        {
+            // The alternative is impossible, e.g. 100% + delta.
+            sequential->accepted |= 1 << i;
+            continue;
+        }
+        // Observing an impossible pass or fail rejects immediately.
+        if (expected == 0)
+            sequential->passLlr[i] = sequential->rejectBound;
+        else
+            sequential->passLlr[i] = Log2Q_4_12(alternative) - Log2Q_4_12(expected);
+        if (expected == Q_4_12(1))
+            sequential->failLlr[i] = sequential->rejectBound;
+        else
+            sequential->failLlr[i] = Log2Q_4_12(Q_4_12(1) - alternative) - Log2Q_4_12(Q_4_12(1) - expected);
+    }
+}
+
+// Returns TRUE if the results are conclusive.
+static bool32 UpdateSequentialTrials(bool32 passed)
+{
+    s32 i;
+    struct SequentialTrials *sequential = &STATE->sequentialTrials;
+
+    sequential->trials++;
+    if (passed)
+        sequential->passes++;
+    for (i = 0; i < 2; i++)
+    {
+        if (sequential->accepted & (1 << i))
+            continue;
+        sequential->llr[i] += passed ? sequential->passLlr[i] : sequential->failLlr[i];
+        if (sequential->llr[i] >= sequential->rejectBound)
+            sequential->rejected = TRUE;
+        else if (sequential->llr[i] <= sequential->acceptBound)
+            sequential->accepted |= 1 << i;
+    }
+    return sequential->rejected || sequential->accepted == 3;
+}
+
+static bool32 SequentialTrialsPassed(void)
+{
+    s32 i;
+    struct SequentialTrials *sequential = &STATE->sequentialTrials;
+
+    if (sequential->rejected)
+        return FALSE;
+    // Inconclusive, so pass if the results are more likely under the
+    // expected ratio than under either alternative.
+    for (i = 0; i < 2; i++)
+    {
+        if (!(sequential->accepted & (1 << i)) && sequential->llr[i] > 0)
+            return FALSE;
+    }
+    return TRUE;
+}
+
 static void CB2_BattleTest_NextTrial(void)
 {
+    bool32 decided;
+
     TearDownBattle();
 
     SetMainCallback2(CB2_BattleTest_NextParameter);
@@ -1390,7 +1565,8 @@ static void CB2_BattleTest_NextTrial(void)
     if (STATE->rngTag)
         STATE->trialRatio = 0;
 
-    if (++STATE->runTrial < STATE->trials)
+    decided = STATE->sequential && UpdateSequentialTrials(gTestRunnerState.result == TEST_RESULT_PASS);
+    if (!decided && ++STATE->runTrial < TrialsEnd())
     {
         PrintTestName();
         gTestRunnerState.result = TEST_RESULT_PASS;
@@ -1399,6 +1575,23 @@ static void CB2_BattleTest_NextTrial(void)
         SetVariablesForRecordedBattle(&DATA.recordedBattle);
         SetMainCallback2(CB2_InitBattle);
     }
+    else if (STATE->sequential)
+    {
+        struct SequentialTrials *sequential = &STATE->sequentialTrials;
+        if (!decided && sequential->maxTrials)
+            Test_ExitWithResult(TEST_RESULT_FAIL, SourceLine(0), ":L%s:%d: Expected conclusive results within %d trials, observed %q", gTestRunnerState.test->filename, SourceLine(0), sequential->maxTrials, Q_4_12(sequential->passes) / sequential->trials);
+        else if (SequentialTrialsPassed())
+            gTestRunnerState.result = TEST_RESULT_PASS;
+        else
+            Test_ExitWithResult(TEST_RESULT_FAIL, SourceLine(0), ":L%s:%d: Expected %q passes/successes, observed %q after %d trials", gTestRunnerState.test->filename, SourceLine(0), STATE->expectedRatio, Q_4_12(sequential->passes) / sequential->trials, sequential->trials);
+    }
+    else if (STATE->trialShards > 1)
+    {
+        // The other trials run in other shards, so Hydra sums the
+        // observed ratios and checks them against the expected ratio.
+        Test_MgbaPrintf(":Q%d %d %d %d", STATE->runParameter, STATE->observedRatio, STATE->expectedRatio, Q_4_12(0.02));
+        gTestRunnerState.result = TEST_RESULT_PASS;
+    }
     else
     {
         if (STATE->rngTag && !STATE->didRunRandomly && STATE->expectedRatio != Q_4_12(0.0) && STATE->expectedRatio != Q_4_12(1.0))
@@ -1412,6 +1605,42 @@ static void CB2_BattleTest_NextTrial(void)
     }
 }
 
+static const char *const sAIBenchmarkPhaseNames[] =
+{
+    [AI_BENCHMARK_LOGIC_DATA] = "SetAiLogicDataForTurn",
+    [AI_BENCHMARK_SWITCHING] = "ShouldSwitch",
+    [AI_BENCHMARK_CHOOSE_MOVE] = "BattleAI_ChooseMoveOrAction",
+};
+
+// Reports the stats as counters and histograms, which Hydra sums over
+// the shards of the test and prints with its result.
+static void PrintAIBenchmark(void)
+{
+    u32 i, j;
+    const struct AIBenchmarkStats *stats = &STATE->aiBenchmark;
+
+    Test_MgbaPrintf(":C%d AI_VS_AI: battles", stats->battles);
+    Test_MgbaPrintf(":C%d AI_VS_AI: won", stats->won);
+    Test_MgbaPrintf(":C%d AI_VS_AI: lost", stats->lost);
+    Test_MgbaPrintf(":C%d AI_VS_AI: drew", stats->drew);
+    Test_MgbaPrintf(":C%d AI_VS_AI: reached %d turns", stats->reachedMaxTurns, AI_VS_AI_MAX_TURNS);
+    for (i = 1; i <= AI_VS_AI_MAX_TURNS; i++)
+    {
+        if (stats->turns[i])
+            Test_MgbaPrintf(":H%d %d AI_VS_AI: turns per battle", i, stats->turns[i]);
+    }
+    for (i = 0; i < AI_BENCHMARK_PHASES_COUNT; i++)
+    {
+        const struct AIBenchmarkSamples *samples = &stats->phases[i];
+        for (j = 0; j < ARRAY_COUNT(samples->log2Counts); j++)
+        {
+            // The highest bin is bounded by the exact max.
+            if (samples->log2Counts[j])
+                Test_MgbaPrintf(":H%d %d AI_VS_AI: %s cycles", min((2u << j) - 1, samples->max), samples->log2Counts[j], sAIBenchmarkPhaseNames[i]);
+        }
+    }
+}
+
 static void BattleTest_TearDown(void *data)
 {
     // Free resources that aren't cleaned up when the battle was
@@ -1420,6 +1649,11 @@ static void BattleTest_TearDown(void *data)
     TestFreeConfigData();
     if (STATE->tearDownBattle)
         TearDownBattle();
+    if (STATE->aiBenchmark.battles != 0)
+    {
+        REG_TM3CNT_H = 0;
+        PrintAIBenchmark();
+    }
 }
 
 static bool32 BattleTest_CheckProgress(void *data)
@@ -1458,7 +1692,10 @@ void Randomly(u32 sourceLine, u32 passes, u32 trials, struct RandomlyContext ctx
     INVALID_IF(STATE->trials != 0, "PASSES_RANDOMLY can only be used once per test");
     INVALID_IF(test->resultsSize > 0 && STATE->parametersCount > 1, "PASSES_RANDOMLY is incompatible with results");
     INVALID_IF(passes > trials, "%d passes specified, but only %d trials", passes, trials);
+    INVALID_IF(ctx.tag && ctx.sequential, "sequential PASSES_RANDOMLY cannot have a tag");
+    INVALID_IF(ctx.maxTrials && !ctx.sequential, ".maxTrials requires .sequential");
     STATE->rngTag = ctx.tag;
+    STATE->sequential = ctx.sequential;
     STATE->rngTrialOffset = 0;
     STATE->runTrial = 0;
     STATE->expectedRatio = Q_4_12(passes) / trials;
@@ -1472,9 +1709,18 @@ void Randomly(u32 sourceLine, u32 passes, u32 trials, struct RandomlyContext ctx
     {
         const rng_value_t defaultSeed = RNG_SEED_DEFAULT;
         INVALID_IF(RngSeedNotDefault(&DATA.recordedBattle.rngSeed), "RNG seed already set");
-        STATE->trials = 50;
+        INVALID_IF(ctx.maxTrials > 50, ".maxTrials must be at most 50");
+        STATE->trials = ctx.maxTrials ? ctx.maxTrials : 50;
         STATE->trialRatio = Q_4_12(1) / STATE->trials;
         DATA.recordedBattle.rngSeed = defaultSeed;
+        if (STATE->sequential)
+            InitSequentialTrials(sourceLine, ctx);
+        if (STATE->trialShards > 1)
+        {
+            STATE->runTrial = STATE->trialShard * BATTLE_TEST_TRIALS_PER_SHARD;
+            if (STATE->runTrial != 0)
+                DATA.recordedBattle.rngSeed = MakeRngValue(STATE->runTrial);
+        }
     }
 }
 
@@ -1497,9 +1743,43 @@ void AILogScores(u32 sourceLine)
     DATA.logAI = TRUE;
 }
 
+void AIVsAI_(u32 sourceLine)
+{
+    INVALID_IF(!IsAITest(), "AI_VS_AI is usable only in AI_SINGLE_BATTLE_TEST & AI_DOUBLE_BATTLE_TEST");
+    DATA.aiVsAi = TRUE;
+    // Times the AI's decisions in units of 256 cycles, see
+    // TestRunner_Battle_AIBenchmarkStop.
+    REG_TM3CNT_H = 0;
+    REG_TM3CNT_L = 0;
+    REG_TM3CNT_H = TIMER_ENABLE | TIMER_256CLK;
+}
+
+void TrainerParty_(u32 sourceLine, u32 side, u32 trainerId)
+{
+    u8 *partySize;
+    struct Pokemon *party;
+    INVALID_IF(!DATA.aiVsAi, "TRAINER_PARTY is usable only in AI_VS_AI tests");
+    INVALID_IF(trainerId == TRAINER_NONE || trainerId >= TRAINERS_COUNT, "Invalid trainer: %d", trainerId);
+    if (side == B_SIDE_PLAYER)
+    {
+        partySize = &DATA.playerPartySize;
+        party = DATA.recordedBattle.playerParty;
+        // Used for the player's trainer pic.
+        DATA.recordedBattle.partnerId = trainerId;
+    }
+    else
+    {
+        partySize = &DATA.opponentPartySize;
+        party = DATA.recordedBattle.opponentParty;
+    }
+    INVALID_IF(*partySize != 0, "TRAINER_PARTY cannot be combined with other Pokemon");
+    *partySize = CreateNPCTrainerPartyFromTrainer(party, GetTrainerStructFromId(trainerId), FALSE, DATA.recordedBattle.battleFlags);
+}
+
 const struct TestRunner gBattleTestRunner =
 {
     .estimateCost = BattleTest_EstimateCost,
+    .estimateShards = BattleTest_EstimateShards,
     .setUp = BattleTest_SetUp,
     .run = BattleTest_Run,
     .tearDown = BattleTest_TearDown,
@@ -2750,6 +3030,41 @@ u32 TestRunner_Battle_GetChosenGimmick(u32 side, u32 partyIndex)
     return DATA.chosenGimmick[side][partyIndex];
 }
 
+// Called from the battle engine, which other test runners can also run.
+static bool32 IsAIVsAIBattleTest(void)
+{
+    return gTestRunnerState.test->runner == &gBattleTestRunner && DATA.aiVsAi;
+}
+
+bool32 TestRunner_Battle_IsAiVsAi(void)
+{
+    return IsAIVsAIBattleTest();
+}
+
+void TestRunner_Battle_CheckTurnLimit(void)
+{
+    if (IsAIVsAIBattleTest()
+     && gBattleOutcome == 0
+     && gBattleResults.battleTurnCounter + 1 >= AI_VS_AI_MAX_TURNS)
+    {
+        gBattleOutcome = B_OUTCOME_DREW;
+        DATA.trial.reachedMaxTurns = TRUE;
+    }
+}
+
+u32 TestRunner_Battle_AIBenchmarkStart(void)
+{
+    return REG_TM3CNT_L;
+}
+
+void TestRunner_Battle_AIBenchmarkStop(enum AIBenchmarkPhase phase, u32 start)
+{
+    // The timer wraps after 65536 * 256 cycles, about a second, so a
+    // single decision must take less than that.
+    if (IsAIVsAIBattleTest())
+        RecordAIBenchmarkSample(&STATE->aiBenchmark.phases[phase], (u16)(REG_TM3CNT_L - start) * 256);
+}
+
 // TODO: Consider storing the last successful i and searching from i+1
 // to improve performance.
 struct AILogLine *GetLogLine(u32 battlerId, u32 moveIndex)
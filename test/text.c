@@ -4,11 +4,14 @@
 #include "battle_main.h"
 #include "battle_message.h"
 #include "battle_setup.h"
+#include "bg.h"
+#include "dma3.h"
 #include "item.h"
 #include "malloc.h"
 #include "main_menu.h"
 #include "string_util.h"
 #include "text.h"
+#include "window.h"
 #include "constants/abilities.h"
 #include "constants/battle.h"
 #include "constants/battle_string_ids.h"
@@ -828,3 +831,225 @@ TEST("Battle strings fit on the battle message window")
     Free(battleString);
 }
 //*/
+
+static const struct BgTemplate sGlyphBgTemplates[] =
+{
+    {
+        .bg = 0,
+        .charBaseIndex = 0,
+        .mapBaseIndex = 31,
+        .screenSize = 0,
+        .paletteMode = 0,
+        .priority = 0,
+        .baseTile = 0,
+    },
+};
+
+static const struct WindowTemplate sGlyphWindowTemplates[] =
+{
+    {
+        .bg = 0,
+        .tilemapLeft = 0,
+        .tilemapTop = 0,
+        .width = 4,
+        .height = 3,
+        .paletteNum = 15,
+        .baseBlock = 1,
+    },
+    DUMMY_WIN_TEMPLATE,
+};
+
+// The nibble-at-a-time blitter that GLYPH_COPY replaced.
+static void GlyphCopyReference(u8 *windowTiles, u32 widthOffset, u32 j, u32 i, u32 *glyphPixels, s32 width, s32 height)
+{
+    u32 xAdd, yAdd, pixelData, bits, toOrr, dummyX;
+    u8 *dst;
+
+    xAdd = j + width;
+    yAdd = i + height;
+    dummyX = j;
+    for (; i < yAdd; i++)
+    {
+        pixelData = *glyphPixels++;
+        for (j = dummyX; j < xAdd; j++)
+        {
+            if ((toOrr = pixelData & 0xF))
+            {
+                dst = windowTiles + ((j / 8) * 32) + ((j % 8) / 2) + ((i / 8) * widthOffset) + ((i % 8) * 4);
+                bits = ((j & 1) * 4);
+                *dst = (toOrr << bits) | (*dst & (0xF0 >> bits));
+            }
+            pixelData >>= 4;
+        }
+    }
+}
+
+static void CopyGlyphToWindowReference(u8 *windowTiles, const struct WindowTemplate *template, u32 currX, u32 currY)
+{
+    u32 widthOffset = template->width * 32;
+    u32 *glyphPixels = gCurGlyph.gfxBufferTop;
+    s32 glyphWidth, glyphHeight;
+
+    if ((glyphWidth = (template->width * 8) - currX) > gCurGlyph.width)
+        glyphWidth = gCurGlyph.width;
+    if ((glyphHeight = (template->height * 8) - currY) > gCurGlyph.height)
+        glyphHeight = gCurGlyph.height;
+
+    if (glyphWidth < 9)
+    {
+        if (glyphHeight < 9)
+        {
+            GlyphCopyReference(windowTiles, widthOffset, currX, currY, glyphPixels, glyphWidth, glyphHeight);
+        }
+        else
+        {
+            GlyphCopyReference(windowTiles, widthOffset, currX, currY, glyphPixels, glyphWidth, 8);
+            GlyphCopyReference(windowTiles, widthOffset, currX, currY + 8, glyphPixels + 16, glyphWidth, glyphHeight - 8);
+        }
+    }
+    else
+    {
+        if (glyphHeight < 9)
+        {
+            GlyphCopyReference(windowTiles, widthOffset, currX, currY, glyphPixels, 8, glyphHeight);
+            GlyphCopyReference(windowTiles, widthOffset, currX + 8, currY, glyphPixels + 8, glyphWidth - 8, glyphHeight);
+        }
+        else
+        {
+            GlyphCopyReference(windowTiles, widthOffset, currX, currY, glyphPixels, 8, 8);
+            GlyphCopyReference(windowTiles, widthOffset, currX + 8, currY, glyphPixels + 8, glyphWidth - 8, 8);
+            GlyphCopyReference(windowTiles, widthOffset, currX, currY + 8, glyphPixels + 16, 8, glyphHeight - 8);
+            GlyphCopyReference(windowTiles, widthOffset, currX + 8, currY + 8, glyphPixels + 24, glyphWidth - 8, glyphHeight - 8);
+        }
+    }
+}
+
+static u32 NextGlyphTestWord(u32 *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+TEST("CopyGlyphToWindow matches the nibble-at-a-time blitter")
+{
+    const u8 heights[] = { 1, 5, 8, 9, 16 };
+    const u8 ys[] = { 0, 3, 8, 13 };
+    const struct WindowTemplate *template = &sGlyphWindowTemplates[0];
+    u32 size = template->width * template->height * TILE_SIZE_4BPP;
+    u32 i, width, height, y, state = 0x2545F491;
+    u32 x = 0;
+    u8 *expected;
+    u8 *tiles;
+    struct TextPrinter printer = {0};
+
+    // Every x in the window, so each x % 8 is drawn both whole and
+    // clipped at the right edge.
+    for (i = 0; i < template->width * 8; i++)
+        PARAMETRIZE { x = i; }
+
+    ResetBgsAndClearDma3BusyFlags(FALSE);
+    InitBgsFromTemplates(0, sGlyphBgTemplates, ARRAY_COUNT(sGlyphBgTemplates));
+    EXPECT(InitWindows(sGlyphWindowTemplates));
+    tiles = gWindows[0].tileData;
+    expected = Alloc(size);
+
+    printer.printerTemplate.windowId = 0;
+    printer.printerTemplate.currentX = x;
+    for (width = 1; width <= 16; width++)
+    {
+        for (height = 0; height < ARRAY_COUNT(heights); height++)
+        {
+            for (y = 0; y < ARRAY_COUNT(ys); y++)
+            {
+                // Random background and glyph pixels, about one in four
+                // of the glyph's transparent.
+                for (i = 0; i < size / 4; i++)
+                    ((u32 *)tiles)[i] = NextGlyphTestWord(&state);
+                for (i = 0; i < ARRAY_COUNT(gCurGlyph.gfxBufferTop); i++)
+                {
+                    u32 pixels = NextGlyphTestWord(&state);
+                    u32 holes = NextGlyphTestWord(&state);
+                    holes = holes & (holes >> 1) & 0x11111111;
+                    gCurGlyph.gfxBufferTop[i] = pixels & ~(holes * 0xF);
+                }
+                gCurGlyph.width = width;
+                gCurGlyph.height = heights[height];
+                printer.printerTemplate.currentY = ys[y];
+
+                memcpy(expected, tiles, size);
+                CopyGlyphToWindowReference(expected, template, x, ys[y]);
+                CopyGlyphToWindow(&printer);
+                EXPECT_EQ(memcmp(expected, tiles, size), 0);
+            }
+        }
+    }
+
+    Free(expected);
+    FreeAllWindowBuffers();
+}
+
+static const struct WindowTemplate sGlyphCacheWindowTemplates[] =
+{
+    {
+        .bg = 0,
+        .tilemapLeft = 0,
+        .tilemapTop = 0,
+        .width = DISPLAY_WIDTH / TILE_WIDTH,
+        .height = 8,
+        .paletteNum = 15,
+        .baseBlock = 1,
+    },
+    {
+        .bg = 0,
+        .tilemapLeft = 0,
+        .tilemapTop = 8,
+        .width = DISPLAY_WIDTH / TILE_WIDTH,
+        .height = 8,
+        .paletteNum = 15,
+        .baseBlock = 1 + (DISPLAY_WIDTH / TILE_WIDTH) * 8,
+    },
+    DUMMY_WIN_TEMPLATE,
+};
+
+// Prints a glyph at a time with an empty glyph cache.
+static void PrintWithoutGlyphCache(u32 windowId, const u8 *str)
+{
+    u32 i;
+    AddTextPrinterParameterized(windowId, FONT_NORMAL, str, 0, 1, 1, NULL);
+    for (i = 0; i < 0x400 && IsTextPrinterActive(windowId); i++)
+    {
+        ClearGlyphCache();
+        RunTextPrinters();
+    }
+}
+
+TEST("Cached glyphs print the same as uncached glyphs")
+{
+    const u32 size = sGlyphCacheWindowTemplates[0].width * sGlyphCacheWindowTemplates[0].height * TILE_SIZE_4BPP;
+    const u8 *str = NULL;
+
+    PARAMETRIZE { str = COMPOUND_STRING("ABAB {COLOR RED}ABAB {COLOR BLUE}BABA {COLOR DARK_GRAY}ABAB"); }
+    // More than the 32 cached glyphs, so the first are evicted before
+    // they are printed again.
+    PARAMETRIZE { str = COMPOUND_STRING("ABCDEFGHIJKLMNOPQRSTUVWXYZ\n{COLOR RED}abcdefghijklm ABC\n{COLOR DARK_GRAY}ABC abc XYZ"); }
+
+    ResetBgsAndClearDma3BusyFlags(FALSE);
+    InitBgsFromTemplates(0, sGlyphBgTemplates, ARRAY_COUNT(sGlyphBgTemplates));
+    EXPECT(InitWindows(sGlyphCacheWindowTemplates));
+    FillWindowPixelBuffer(1, PIXEL_FILL(1));
+    PrintWithoutGlyphCache(1, str);
+
+    // Once into an empty cache, and once with every glyph cached.
+    ClearGlyphCache();
+    FillWindowPixelBuffer(0, PIXEL_FILL(1));
+    AddTextPrinterParameterized(0, FONT_NORMAL, str, 0, 1, 0, NULL);
+    EXPECT_EQ(memcmp(gWindows[0].tileData, gWindows[1].tileData, size), 0);
+    FillWindowPixelBuffer(0, PIXEL_FILL(1));
+    AddTextPrinterParameterized(0, FONT_NORMAL, str, 0, 1, 0, NULL);
+    EXPECT_EQ(memcmp(gWindows[0].tileData, gWindows[1].tileData, size), 0);
+
+    ClearDma3Requests();
+    FreeAllWindowBuffers();
+}
@@ -0,0 +1,182 @@
+#include "global.h"
+#include "bg.h"
+#include "dma3.h"
+#include "text.h"
+#include "window.h"
+#include "test/test.h"
+
+static const struct BgTemplate sBgTemplates[] =
+{
+    {
+        .bg = 0,
+        .charBaseIndex = 0,
+        .mapBaseIndex = 31,
+        .screenSize = 0,
+        .paletteMode = 0,
+        .priority = 0,
+        .baseTile = 0,
+    },
+};
+
+static const struct WindowTemplate sWindowTemplates[] =
+{
+    {
+        .bg = 0,
+        .tilemapLeft = 0,
+        .tilemapTop = 0,
+        .width = DISPLAY_WIDTH / TILE_WIDTH,
+        .height = DISPLAY_HEIGHT / TILE_HEIGHT,
+        .paletteNum = 15,
+        .baseBlock = 1,
+    },
+    DUMMY_WIN_TEMPLATE,
+};
+
+TEST("CopyWindowToVram benchmark (full screen window)")
+{
+    struct Benchmark copyWindowToVram;
+
+    ResetBgsAndClearDma3BusyFlags(FALSE);
+    InitBgsFromTemplates(0, sBgTemplates, ARRAY_COUNT(sBgTemplates));
+    EXPECT(InitWindows(sWindowTemplates));
+    FillWindowPixelBuffer(0, PIXEL_FILL(1));
+    ClearDma3Requests();
+
+    BENCHMARK(&copyWindowToVram)
+    {
+        CopyWindowToVram(0, COPYWIN_FULL);
+    }
+
+    ClearDma3Requests();
+    FreeAllWindowBuffers();
+    EXPECT_BASELINE(copyWindowToVram);
+}
+
+static const u8 sTilePixels[TILE_SIZE_4BPP] = {0};
+
+TEST("Drawing to a window marks the tiles under it dirty")
+{
+    struct TextPrinter printer = {0};
+
+    ResetBgsAndClearDma3BusyFlags(FALSE);
+    InitBgsFromTemplates(0, sBgTemplates, ARRAY_COUNT(sBgTemplates));
+    EXPECT(InitWindows(sWindowTemplates));
+    CopyWindowToVram(0, COPYWIN_GFX);
+    ClearDma3Requests();
+    EXPECT_EQ(gWindows[0].dirtyRight, 0);
+    EXPECT_EQ(gWindows[0].dirtyBottom, 0);
+
+    // Pixels 9-16 of row 10 are in tiles 1-2 of tile row 1.
+    FillWindowPixelRect(0, PIXEL_FILL(2), 9, 10, 8, 1);
+    EXPECT_EQ(gWindows[0].dirtyLeft, 1);
+    EXPECT_EQ(gWindows[0].dirtyTop, 1);
+    EXPECT_EQ(gWindows[0].dirtyRight, 3);
+    EXPECT_EQ(gWindows[0].dirtyBottom, 2);
+
+    BlitBitmapToWindow(0, sTilePixels, 40, 20, 8, 8);
+    EXPECT_EQ(gWindows[0].dirtyLeft, 1);
+    EXPECT_EQ(gWindows[0].dirtyTop, 1);
+    EXPECT_EQ(gWindows[0].dirtyRight, 6);
+    EXPECT_EQ(gWindows[0].dirtyBottom, 4);
+
+    gCurGlyph.width = 6;
+    gCurGlyph.height = 16;
+    printer.printerTemplate.windowId = 0;
+    printer.printerTemplate.currentX = 200;
+    printer.printerTemplate.currentY = 140;
+    CopyGlyphToWindow(&printer);
+    EXPECT_EQ(gWindows[0].dirtyLeft, 1);
+    EXPECT_EQ(gWindows[0].dirtyTop, 1);
+    EXPECT_EQ(gWindows[0].dirtyRight, 26);
+    EXPECT_EQ(gWindows[0].dirtyBottom, 20);
+
+    // Clipped to the window.
+    FillWindowPixelRect(0, PIXEL_FILL(2), 236, 0, 16, 8);
+    EXPECT_EQ(gWindows[0].dirtyLeft, 1);
+    EXPECT_EQ(gWindows[0].dirtyTop, 0);
+    EXPECT_EQ(gWindows[0].dirtyRight, 30);
+    EXPECT_EQ(gWindows[0].dirtyBottom, 20);
+
+    CopyWindowToVram(0, COPYWIN_FULL);
+    ClearDma3Requests();
+    EXPECT_EQ(gWindows[0].dirtyRight, 0);
+    EXPECT_EQ(gWindows[0].dirtyBottom, 0);
+
+    // Does not grow from the tiles which were already copied.
+    MarkWindowDirty(0, 16, 16, 1, 1);
+    EXPECT_EQ(gWindows[0].dirtyLeft, 2);
+    EXPECT_EQ(gWindows[0].dirtyTop, 2);
+    EXPECT_EQ(gWindows[0].dirtyRight, 3);
+    EXPECT_EQ(gWindows[0].dirtyBottom, 3);
+
+    FreeAllWindowBuffers();
+}
+
+TEST("Handing out a window's tiles or scrolling it marks the whole window dirty")
+{
+    ResetBgsAndClearDma3BusyFlags(FALSE);
+    InitBgsFromTemplates(0, sBgTemplates, ARRAY_COUNT(sBgTemplates));
+    EXPECT(InitWindows(sWindowTemplates));
+
+    CopyWindowToVram(0, COPYWIN_GFX);
+    GetWindowAttribute(0, WINDOW_WIDTH);
+    EXPECT_EQ(gWindows[0].dirtyRight, 0);
+    EXPECT_EQ(gWindows[0].dirtyBottom, 0);
+    GetWindowAttribute(0, WINDOW_TILE_DATA);
+    EXPECT_EQ(gWindows[0].dirtyLeft, 0);
+    EXPECT_EQ(gWindows[0].dirtyTop, 0);
+    EXPECT_EQ(gWindows[0].dirtyRight, DISPLAY_WIDTH / TILE_WIDTH);
+    EXPECT_EQ(gWindows[0].dirtyBottom, DISPLAY_HEIGHT / TILE_HEIGHT);
+
+    CopyWindowToVram(0, COPYWIN_GFX);
+    ScrollWindow(0, 0, 8, PIXEL_FILL(1));
+    EXPECT_EQ(gWindows[0].dirtyLeft, 0);
+    EXPECT_EQ(gWindows[0].dirtyTop, 0);
+    EXPECT_EQ(gWindows[0].dirtyRight, DISPLAY_WIDTH / TILE_WIDTH);
+    EXPECT_EQ(gWindows[0].dirtyBottom, DISPLAY_HEIGHT / TILE_HEIGHT);
+
+    ClearDma3Requests();
+    FreeAllWindowBuffers();
+}
+
+TEST("A text printer copies only the tile rows its glyph dirtied")
+{
+    static const u8 sText[] = _("A");
+    const u32 width = DISPLAY_WIDTH / TILE_WIDTH;
+    const u32 tiles = width * (DISPLAY_HEIGHT / TILE_HEIGHT);
+    // The window's tiles start at baseBlock 1 of char base 0.
+    u32 *vram = (u32 *)(BG_VRAM + TILE_SIZE_4BPP);
+    u32 *tileData;
+    u16 ime = REG_IME;
+    u32 i, frames;
+
+    ResetBgsAndClearDma3BusyFlags(FALSE);
+    InitBgsFromTemplates(0, sBgTemplates, ARRAY_COUNT(sBgTemplates));
+    EXPECT(InitWindows(sWindowTemplates));
+    REG_IME = 0;
+    tileData = (u32 *)gWindows[0].tileData;
+    FillWindowPixelBuffer(0, PIXEL_FILL(1));
+    CopyWindowToVram(0, COPYWIN_GFX);
+    ClearDma3Requests();
+    CpuFill32(0xEEEEEEEE, vram, tiles * TILE_SIZE_4BPP);
+
+    // A glyph at (8, 16) is in tile rows 2 and 3.
+    AddTextPrinterParameterized(0, FONT_NORMAL, sText, 8, 16, 1, NULL);
+    for (frames = 0; frames < 16 && IsTextPrinterActive(0); frames++)
+        RunTextPrinters();
+    while (REG_VCOUNT >= DISPLAY_HEIGHT)
+        ;
+    ProcessDma3Requests();
+    ClearDma3Requests();
+    REG_IME = ime;
+
+    EXPECT(!IsTextPrinterActive(0));
+    for (i = 0; i < 2 * width * TILE_SIZE_4BPP / 4; i++)
+        EXPECT_EQ(vram[i], 0xEEEEEEEE);
+    for (i = (2 * width + 1) * TILE_SIZE_4BPP / 4; i < (2 * width + 2) * TILE_SIZE_4BPP / 4; i++)
+        EXPECT_EQ(vram[i], tileData[i]);
+    for (i = 4 * width * TILE_SIZE_4BPP / 4; i < tiles * TILE_SIZE_4BPP / 4; i++)
+        EXPECT_EQ(vram[i], 0xEEEEEEEE);
+
+    FreeAllWindowBuffers();
+}
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""Prints the test files which can observe the changes since a git revision.
+
+The output is a space-separated list of filename prefixes, suitable for
+patching into gTestRunnerFiles. An empty output means that every test
+should run, either because every test file can observe the changes, or
+because a change could not be attributed to any object (e.g. a Makefile
+change).
+
+A test file can observe a changed file if:
+- its object's dependency file (.d) lists the changed file, or
+- it references a symbol defined by an object whose dependencies include
+  the changed file, either directly or through a chain of objects which
+  reference each other's symbols.
+
+The chain can be shortened with --max-depth, at the cost of no longer
+being conservative: e.g. --max-depth=1 only selects tests which directly
+reference a symbol in a changed object.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+
+# Changes to these can affect every object, so run everything.
+FULL_RUN_PREFIXES = ("Makefile", "make_tools.mk", "libagbsyscall/", "tools/", "charmap.txt", "sym_")
+FULL_RUN_SUFFIXES = (".mk", ".ld")
+# Changes to these cannot affect any test.
+IGNORED_PREFIXES = (".github/", "docs/", "INSTALL.md", "README.md", ".gitignore", ".gitattributes")
+
+def stem(path):
+    """Strips every extension, e.g. graphics/a.4bpp.lz -> graphics/a."""
+    directory, base = os.path.split(path)
+    return os.path.join(directory, base.split(".")[0])
+
+def git_changed_files(base):
+    changed = subprocess.run(["git", "diff", "--name-only", base, "--"], check=True, capture_output=True, text=True).stdout.split()
+    untracked = subprocess.run(["git", "ls-files", "--others", "--exclude-standard"], check=True, capture_output=True, text=True).stdout.split()
+    return set(changed) | set(untracked)
+
+def read_dependencies(obj_dir):
+    """Returns {object: set(dependencies)} for every object in obj_dir."""
+    deps = {}
+    for root, _, files in os.walk(obj_dir):
+        for name in files:
+            if not name.endswith(".o"):
+                continue
+            obj = os.path.join(root, name)
+            rel = os.path.relpath(obj, obj_dir)
+            deps[obj] = {stem(rel)}
+            d = obj[:-2] + ".d"
+            if os.path.exists(d):
+                with open(d) as f:
+                    # The first rule is '<object>: <dependencies>'.
+                    rule = f.readline()
+                deps[obj] |= set(rule.partition(":")[2].split())
+    return deps
+
+def read_symbols(nm, objs):
+    """Returns ({symbol: set(objects)} of definitions, {object: set(symbols)} of references)."""
+    defs = {}
+    refs = {obj: set() for obj in objs}
+    objs = sorted(objs)
+    for i in range(0, len(objs), 256):
+        out = subprocess.run([nm, "-A", "--format=posix"] + objs[i:i+256], check=True, capture_output=True, text=True).stdout
+        for line in out.splitlines():
+            obj, _, rest = line.partition(": ")
+            fields = rest.split()
+            if len(fields) < 2:
+                continue
+            symbol, kind = fields[0], fields[1]
+            if kind == "U":
+                refs[obj].add(symbol)
+            elif kind.isupper():
+                defs.setdefault(symbol, set()).add(obj)
+    return defs, refs
+
+def collapse(selected, all_tests):
+    """Replaces test files with the highest directory whose test files are
+    all selected."""
+    def fully_selected(directory):
+        prefix = directory + "/"
+        return all(path in selected for path in all_tests if path.startswith(prefix))
+
+    prefixes = set()
+    for path in selected:
+        prefix = path
+        directory = os.path.dirname(path)
+        while directory and fully_selected(directory):
+            prefix = directory + "/"
+            directory = os.path.dirname(directory)
+        prefixes.add(prefix)
+    return prefixes
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--base", required=True, help="git revision to compare against")
+    parser.add_argument("--obj-dir", required=True, help="directory containing the test build's objects")
+    parser.add_argument("--nm", default="arm-none-eabi-nm")
+    parser.add_argument("--max-depth", type=int, default=-1, help="maximum length of symbol reference chains (default: unlimited)")
+    parser.add_argument("--max-length", type=int, default=4095, help="maximum length of the output")
+    parser.add_argument("-v", "--verbose", action="store_true")
+    args = parser.parse_args()
+
+    def log(msg):
+        print("affected_tests: " + msg, file=sys.stderr)
+
+    changed = git_changed_files(args.base)
+    changed = {path for path in changed if not path.startswith(IGNORED_PREFIXES)}
+    for path in sorted(changed):
+        if path.startswith(FULL_RUN_PREFIXES) or path.endswith(FULL_RUN_SUFFIXES):
+            log(f"{path} changed, running all tests")
+            return
+
+    deps = read_dependencies(args.obj_dir)
+    test_dir = os.path.join(args.obj_dir, "test") + os.sep
+    test_objs = {obj for obj in deps if obj.startswith(test_dir)}
+    all_tests = {os.path.relpath(obj, args.obj_dir)[:-2] + ".c" for obj in test_objs}
+
+    changed_objs = set()
+    explained = set()
+    for obj, obj_deps in deps.items():
+        # Match by stem so that e.g. a .png matches the .4bpp built from it.
+        dep_stems = {stem(d) for d in obj_deps}
+        hits = {path for path in changed if path in obj_deps or stem(path) in dep_stems}
+        if hits:
+            changed_objs.add(obj)
+            explained |= hits
+            if args.verbose:
+                log(f"{os.path.relpath(obj, args.obj_dir)} depends on {' '.join(sorted(hits))}")
+    # Deleted test files have no object to depend on them.
+    unexplained = {path for path in changed - explained if not (path.startswith("test/") and not os.path.exists(path))}
+    if unexplained:
+        log(f"{' '.join(sorted(unexplained))} not used by any object, running all tests")
+        return
+
+    defs, refs = read_symbols(args.nm, deps.keys())
+    referrers = {obj: set() for obj in deps}
+    for obj, symbols in refs.items():
+        for symbol in symbols:
+            for definer in defs.get(symbol, ()):
+                if definer != obj:
+                    referrers[definer].add(obj)
+
+    observers = set(changed_objs)
+    frontier = set(changed_objs)
+    depth = 0
+    while frontier and depth != args.max_depth:
+        frontier = {referrer for obj in frontier for referrer in referrers[obj]} - observers
+        observers |= frontier
+        depth += 1
+
+    selected = {os.path.relpath(obj, args.obj_dir)[:-2] + ".c" for obj in observers & test_objs}
+    log(f"{len(selected)}/{len(all_tests)} test files can observe the changes since {args.base}")
+    if selected >= all_tests:
+        return
+    if not selected:
+        # Matches no filename, so no tests run.
+        print("-")
+        return
+
+    output = " ".join(sorted(collapse(selected, all_tests)))
+    if len(output) > args.max_length:
+        log("too many test files to list, running all tests")
+        return
+    print(output)
+
+if __name__ == "__main__":
+    main()
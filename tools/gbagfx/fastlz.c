@@ -0,0 +1,230 @@
+// A byte-aligned LZ format in the style of LZ4, which is quicker for the
+// GBA to decompress than the BIOS's LZ77. After the usual 4-byte header
+// (0x40, then the 24-bit uncompressed size), the data is a series of
+// sequences, each of which is:
+//   a token byte, whose high nibble is the literal count and whose low
+//     nibble is the match length minus 4;
+//   if the literal count is 15, bytes which are added to it, up to and
+//     including the first which is not 255;
+//   the literals;
+//   unless the data is complete, the match offset as a 16-bit little-endian
+//     number, then, if the match length is 19, extra bytes as above.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "global.h"
+#include "fastlz.h"
+
+#define FASTLZ_TYPE 0x40
+#define MIN_MATCH 4
+#define MAX_OFFSET 0xFFFF
+#define HASH_BITS 12
+#define MAX_CHAIN 256
+
+static bool ReadLength(unsigned char *src, int srcSize, int *srcPos, int *length)
+{
+    unsigned char byte;
+
+    do
+    {
+        if (*srcPos >= srcSize)
+            return false;
+        byte = src[(*srcPos)++];
+        *length += byte;
+    } while (byte == 255);
+
+    return true;
+}
+
+unsigned char *FastLZDecompress(unsigned char *src, int srcSize, int *uncompressedSize)
+{
+    if (srcSize < 4 || src[0] != FASTLZ_TYPE)
+        goto fail;
+
+    int destSize = (src[3] << 16) | (src[2] << 8) | src[1];
+
+    unsigned char *dest = malloc(destSize);
+
+    if (dest == NULL)
+        goto fail;
+
+    int srcPos = 4;
+    int destPos = 0;
+
+    while (destPos < destSize)
+    {
+        if (srcPos >= srcSize)
+            goto fail;
+
+        unsigned char token = src[srcPos++];
+        int length = token >> 4;
+
+        if (length == 15 && !ReadLength(src, srcSize, &srcPos, &length))
+            goto fail;
+        if (srcPos + length > srcSize || destPos + length > destSize)
+            goto fail;
+
+        memcpy(&dest[destPos], &src[srcPos], length);
+        srcPos += length;
+        destPos += length;
+
+        if (destPos == destSize)
+            break;
+
+        if (srcPos + 1 >= srcSize)
+            goto fail;
+
+        int offset = src[srcPos] | (src[srcPos + 1] << 8);
+
+        srcPos += 2;
+        length = (token & 0xF) + MIN_MATCH;
+
+        if (length == 15 + MIN_MATCH && !ReadLength(src, srcSize, &srcPos, &length))
+            goto fail;
+        if (offset == 0 || offset > destPos || destPos + length > destSize)
+            goto fail;
+
+        for (int i = 0; i < length; i++, destPos++)
+            dest[destPos] = dest[destPos - offset];
+    }
+
+    *uncompressedSize = destSize;
+    return dest;
+
+fail:
+    FATAL_ERROR("Fatal error while decompressing fast LZ file.\n");
+}
+
+static int Hash(unsigned char *src)
+{
+    unsigned int value = src[0] | (src[1] << 8) | (src[2] << 16) | ((unsigned int)src[3] << 24);
+
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void WriteLength(unsigned char *dest, int *destPos, int length)
+{
+    while (length >= 255)
+    {
+        dest[(*destPos)++] = 255;
+        length -= 255;
+    }
+    dest[(*destPos)++] = length;
+}
+
+unsigned char *FastLZCompress(unsigned char *src, int srcSize, int *compressedSize)
+{
+    if (srcSize <= 0 || srcSize > 0xFFFFFF)
+        goto fail;
+
+    // Incompressible data grows by a byte per 255 literals, plus a token.
+    int worstCaseDestSize = 4 + srcSize + srcSize / 255 + 16;
+
+    // Round up to the next multiple of four.
+    worstCaseDestSize = (worstCaseDestSize + 3) & ~3;
+
+    unsigned char *dest = malloc(worstCaseDestSize);
+    int *head = malloc(sizeof(int) << HASH_BITS);
+    int *chain = malloc(sizeof(int) * srcSize);
+
+    if (dest == NULL || head == NULL || chain == NULL)
+        goto fail;
+
+    for (int i = 0; i < (1 << HASH_BITS); i++)
+        head[i] = -1;
+
+    // header
+    dest[0] = FASTLZ_TYPE;
+    dest[1] = srcSize;
+    dest[2] = srcSize >> 8;
+    dest[3] = srcSize >> 16;
+
+    int srcPos = 0;
+    int literalStart = 0;
+    int destPos = 4;
+
+    for (;;)
+    {
+        int bestLength = 0;
+        int bestOffset = 0;
+
+        if (srcPos + MIN_MATCH <= srcSize)
+        {
+            int hash = Hash(&src[srcPos]);
+            int depth = 0;
+
+            for (int candidate = head[hash];
+                 candidate >= 0 && srcPos - candidate <= MAX_OFFSET && depth < MAX_CHAIN;
+                 candidate = chain[candidate], depth++)
+            {
+                int length = 0;
+
+                while (srcPos + length < srcSize && src[candidate + length] == src[srcPos + length])
+                    length++;
+
+                if (length > bestLength)
+                {
+                    bestLength = length;
+                    bestOffset = srcPos - candidate;
+                }
+            }
+
+            chain[srcPos] = head[hash];
+            head[hash] = srcPos;
+        }
+
+        if (bestLength < MIN_MATCH && srcPos < srcSize)
+        {
+            srcPos++;
+            continue;
+        }
+
+        // Emit the literals, and the match if there is one.
+        int literalCount = srcPos - literalStart;
+        int matchLength = bestLength >= MIN_MATCH ? bestLength - MIN_MATCH : 0;
+        int token = ((literalCount < 15 ? literalCount : 15) << 4) | (matchLength < 15 ? matchLength : 15);
+
+        dest[destPos++] = token;
+        if (literalCount >= 15)
+            WriteLength(dest, &destPos, literalCount - 15);
+        memcpy(&dest[destPos], &src[literalStart], literalCount);
+        destPos += literalCount;
+
+        if (srcPos == srcSize)
+            break;
+
+        dest[destPos++] = bestOffset;
+        dest[destPos++] = bestOffset >> 8;
+        if (matchLength >= 15)
+            WriteLength(dest, &destPos, matchLength - 15);
+
+        // Keep the skipped positions in the hash chains.
+        for (int i = 1; i < bestLength && srcPos + i + MIN_MATCH <= srcSize; i++)
+        {
+            int hash = Hash(&src[srcPos + i]);
+
+            chain[srcPos + i] = head[hash];
+            head[hash] = srcPos + i;
+        }
+
+        srcPos += bestLength;
+        literalStart = srcPos;
+
+        if (srcPos == srcSize)
+            break;
+    }
+
+    free(head);
+    free(chain);
+
+    // Pad to a multiple of four.
+    while (destPos & 3)
+        dest[destPos++] = 0;
+
+    *compressedSize = destPos;
+    return dest;
+
+fail:
+    FATAL_ERROR("Fatal error while compressing fast LZ file.\n");
+}
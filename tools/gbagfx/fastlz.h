@@ -0,0 +1,7 @@
+#ifndef FASTLZ_H
+#define FASTLZ_H
+
+unsigned char *FastLZDecompress(unsigned char *src, int srcSize, int *uncompressedSize);
+unsigned char *FastLZCompress(unsigned char *src, int srcSize, int *compressedSize);
+
+#endif // FASTLZ_H
@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""Picks the hottest functions to run from IWRAM within a budget.
+
+Reads how hot each function is from one or more profiles, and their sizes
+and sections from the linker map, then writes a linker script fragment
+which places the chosen functions' sections in .iwram (see
+ld_script_iwram_hot.ld) and prints a report.
+
+A profile is either the debug log of a profiling build (`make profile`),
+whose 'PROFILE: ...' lines weigh each function by its total cycles, or a
+text file of '<function or address> <weight>' lines, e.g. from an
+emulator's profiler. The Frame, CB1, CB2 and VBlank lines of a profiling
+build time everything their callback calls (VBlank even times the whole
+interrupt handler), so they are skipped rather than credited to the
+callback; the remaining kinds still include their callees, so an
+emulator's self-time profile gives better results. Addresses may be of
+the function's ROM or IWRAM copy, and may have the Thumb bit set.
+
+Functions are chosen greedily by weight per byte. Each function must be
+in its own section, which the build does with -ffunction-sections.
+Functions which are not in the map as a '.text.<name>' section (e.g.
+assembly) are reported and skipped.
+"""
+
+import argparse
+import re
+import sys
+
+PROFILE_LINE = re.compile(r"PROFILE: (\S+) 0x([0-9a-fA-F]+): (\d+) calls, \d+% of frames, cycles mean (\d+)")
+# Profiled kinds which time a dispatcher and everything it calls.
+INCLUSIVE_PROFILE_KINDS = {"Frame", "CB1", "CB2", "VBlank"}
+# '<section> <address> <size> <object>', which ld wraps after long section names.
+MAP_SECTION = re.compile(r"^ (\.text\.\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S+)$")
+MAP_WRAPPED_SECTION = re.compile(r"^ (\.text\.\S+)$")
+MAP_WRAPPED_REST = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S+)$")
+
+class Function:
+    def __init__(self, name, section, obj, address, size):
+        self.name = name
+        self.section = section
+        self.obj = obj
+        self.address = address
+        self.size = size
+        self.weight = 0
+
+def read_map(path):
+    """Returns the functions in their own sections, keyed by their names
+    and by their addresses."""
+    by_name = {}
+    by_address = {}
+    with open(path) as f:
+        lines = f.read().splitlines()
+    i = 0
+    while i < len(lines):
+        match = MAP_SECTION.match(lines[i])
+        if match:
+            section, address, size, obj = match.groups()
+        else:
+            match = MAP_WRAPPED_SECTION.match(lines[i])
+            rest = MAP_WRAPPED_REST.match(lines[i + 1]) if match and i + 1 < len(lines) else None
+            if not rest:
+                i += 1
+                continue
+            section = match.group(1)
+            address, size, obj = rest.groups()
+            i += 1
+        i += 1
+
+        size = int(size, 16)
+        if size == 0:
+            continue
+        name = section[len(".text."):]
+        function = Function(name, section, obj, int(address, 16), size)
+        # Static functions can share a name, which the object disambiguates.
+        by_name.setdefault(name, []).append(function)
+        by_address[function.address] = function
+    return by_name, by_address
+
+def read_profile(path, by_name, by_address, unknown):
+    """Adds each function's weight from a profile."""
+    with open(path, errors="replace") as f:
+        for line in f:
+            match = PROFILE_LINE.search(line)
+            if match:
+                kind, address, calls, mean = match.groups()
+                if kind in INCLUSIVE_PROFILE_KINDS:
+                    continue
+                key = "0x" + address
+                weight = int(calls) * int(mean)
+            else:
+                fields = line.split()
+                if len(fields) != 2 or line.startswith("#"):
+                    continue
+                key = fields[0]
+                try:
+                    weight = float(fields[1])
+                except ValueError:
+                    continue
+
+            if key.lower().startswith("0x"):
+                functions = [by_address.get(int(key, 16) & ~1)]
+            else:
+                functions = by_name.get(key, [None])
+            if functions[0] is None:
+                unknown[key] = unknown.get(key, 0) + weight
+                continue
+            for function in functions:
+                function.weight += weight / len(functions)
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--map", required=True, help="linker map of the ROM")
+    parser.add_argument("--budget", type=int, required=True, help="bytes of IWRAM to fill")
+    parser.add_argument("--output", required=True, help="linker script fragment to write")
+    parser.add_argument("--exclude", action="append", default=[], help="function never to place in IWRAM (repeatable)")
+    parser.add_argument("profiles", nargs="+")
+    args = parser.parse_args()
+
+    by_name, by_address = read_map(args.map)
+    if not by_name:
+        sys.exit(f"iwram_hot: no .text.<function> sections in {args.map}, is the ROM built with -ffunction-sections?")
+
+    unknown = {}
+    for profile in args.profiles:
+        read_profile(profile, by_name, by_address, unknown)
+
+    functions = [function for functions in by_name.values() for function in functions
+                 if function.weight > 0 and function.name not in args.exclude]
+    functions.sort(key=lambda function: function.weight / function.size, reverse=True)
+    total_weight = sum(function.weight for function in functions) + sum(unknown.values())
+
+    chosen = []
+    used = 0
+    for function in functions:
+        # Sections are 4-byte aligned in .iwram.
+        size = (function.size + 3) & ~3
+        if used + size <= args.budget:
+            chosen.append(function)
+            used += size
+
+    with open(args.output, "w") as f:
+        f.write("/* Generated by tools/iwram_hot/iwram_hot.py, see `make iwram-hot`. */\n")
+        for function in sorted(chosen, key=lambda function: (function.obj, function.name)):
+            f.write(f"{function.obj}({function.section});\n")
+
+    def share(weight):
+        return 100 * weight / total_weight if total_weight else 0
+
+    print(f"{'function':<40} {'object':<32} {'bytes':>6} {'weight %':>8}  placed")
+    for function in functions:
+        placed = "yes" if function in chosen else "no"
+        print(f"{function.name:<40} {function.obj:<32} {function.size:>6} {share(function.weight):>8.2f}  {placed}")
+    for key, weight in sorted(unknown.items(), key=lambda item: item[1], reverse=True):
+        print(f"{key:<40} {'(not in its own section)':<32} {'':>6} {share(weight):>8.2f}  no")
+    print(f"{len(chosen)} functions, {used}/{args.budget} bytes of IWRAM, "
+          f"{share(sum(function.weight for function in chosen)):.2f}% of the profiled weight")
+
+if __name__ == "__main__":
+    main()
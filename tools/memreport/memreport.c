@@ -0,0 +1,477 @@
+// Reports how much of IWRAM, EWRAM and ROM a linked ELF uses, per memory
+// region, per object (from the linker map) and per symbol (from the ELF),
+// optionally compared against a baseline written by a previous run.
+//
+// Usage: memreport [options] ELF MAP
+//   --top N                 number of objects and symbols to list per region (default 10)
+//   --baseline FILE         compare against FILE
+//   --write-baseline FILE   write this build's usage to FILE
+//   --budget REGION=BYTES   fail if REGION (IWRAM, EWRAM or ROM) uses more than BYTES
+//
+// Exits with 1 if a region is over its budget.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "elf.h"
+
+#define FATAL_ERROR(format, ...)            \
+do                                          \
+{                                           \
+    fprintf(stderr, format, ##__VA_ARGS__); \
+    exit(1);                                \
+} while (0)
+
+#define OBJECTS_HASH_SIZE 16384
+
+enum Region
+{
+    REGION_EWRAM,
+    REGION_IWRAM,
+    REGION_ROM,
+    REGIONS_COUNT,
+};
+
+struct RegionInfo
+{
+    const char *name;
+    uint32_t start;
+    uint32_t capacity;
+    uint32_t used;
+    uint32_t initialized; // Copied from ROM at boot, e.g. IWRAM_INIT and IWRAM_RODATA.
+    uint32_t baseline;
+    uint32_t budget;
+};
+
+static struct RegionInfo sRegions[REGIONS_COUNT] =
+{
+    [REGION_EWRAM] = { "EWRAM", 0x02000000, 256 * 1024 },
+    [REGION_IWRAM] = { "IWRAM", 0x03000000, 32 * 1024 },
+    [REGION_ROM]   = { "ROM",   0x08000000, 32 * 1024 * 1024 },
+};
+
+// An object's usage of one region, which is also how baselines are kept.
+struct ObjectUsage
+{
+    char *name;
+    enum Region region;
+    uint32_t size;
+    uint32_t baseline;
+};
+
+struct SymbolUsage
+{
+    const char *name;
+    enum Region region;
+    uint32_t size;
+};
+
+static struct ObjectUsage *sObjects[OBJECTS_HASH_SIZE];
+static int sObjectsCount;
+static bool sHasBaseline;
+
+static int GetRegion(uint32_t address)
+{
+    for (int i = 0; i < REGIONS_COUNT; i++)
+    {
+        if (address >= sRegions[i].start && address - sRegions[i].start < sRegions[i].capacity)
+            return i;
+    }
+    return -1;
+}
+
+static int GetRegionByName(const char *name)
+{
+    for (int i = 0; i < REGIONS_COUNT; i++)
+    {
+        if (strcmp(name, sRegions[i].name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static struct ObjectUsage *GetObject(const char *name, enum Region region)
+{
+    uint32_t hash = region;
+    for (const char *c = name; *c != '\0'; c++)
+        hash = hash * 31 + (unsigned char)*c;
+
+    for (uint32_t i = hash % OBJECTS_HASH_SIZE; ; i = (i + 1) % OBJECTS_HASH_SIZE)
+    {
+        struct ObjectUsage *object = sObjects[i];
+        if (object == NULL)
+        {
+            if (sObjectsCount == OBJECTS_HASH_SIZE - 1)
+                FATAL_ERROR("error: more than %d objects\n", OBJECTS_HASH_SIZE - 1);
+            object = calloc(1, sizeof(*object));
+            object->name = malloc(strlen(name) + 1);
+            strcpy(object->name, name);
+            object->region = region;
+            sObjects[i] = object;
+            sObjectsCount++;
+            return object;
+        }
+        if (object->region == region && strcmp(object->name, name) == 0)
+            return object;
+    }
+}
+
+static unsigned char *ReadWholeFile(const char *path, long *size)
+{
+    FILE *fp = fopen(path, "rb");
+
+    if (fp == NULL)
+        FATAL_ERROR("error: failed to open \"%s\" for reading\n", path);
+
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    unsigned char *buffer = malloc(*size + 1);
+    if (buffer == NULL)
+        FATAL_ERROR("error: failed to allocate memory for reading \"%s\"\n", path);
+    if (fread(buffer, *size, 1, fp) != 1)
+        FATAL_ERROR("error: failed to read \"%s\"\n", path);
+    buffer[*size] = '\0';
+
+    fclose(fp);
+    return buffer;
+}
+
+// Adds up the allocated sections and returns the sized symbols.
+static struct SymbolUsage *ReadElf(const char *path, int *symbolsCount)
+{
+    long size;
+    unsigned char *elf = ReadWholeFile(path, &size);
+    const Elf32_Ehdr *ehdr = (const Elf32_Ehdr *)elf;
+
+    if (size < (long)sizeof(*ehdr) || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 || ehdr->e_ident[EI_CLASS] != ELFCLASS32)
+        FATAL_ERROR("error: \"%s\" is not a 32-bit ELF file\n", path);
+
+    const Elf32_Shdr *shdrs = (const Elf32_Shdr *)(elf + ehdr->e_shoff);
+    const Elf32_Shdr *symtab = NULL;
+
+    for (int i = 0; i < ehdr->e_shnum; i++)
+    {
+        if (shdrs[i].sh_type == SHT_SYMTAB)
+            symtab = &shdrs[i];
+        if (!(shdrs[i].sh_flags & SHF_ALLOC) || shdrs[i].sh_size == 0)
+            continue;
+        int region = GetRegion(shdrs[i].sh_addr);
+        if (region < 0)
+            continue;
+        sRegions[region].used += shdrs[i].sh_size;
+        if (region != REGION_ROM && shdrs[i].sh_type != SHT_NOBITS)
+            sRegions[region].initialized += shdrs[i].sh_size;
+    }
+
+    if (symtab == NULL)
+        FATAL_ERROR("error: \"%s\" has no symbol table\n", path);
+
+    const Elf32_Sym *syms = (const Elf32_Sym *)(elf + symtab->sh_offset);
+    const char *strtab = (const char *)(elf + shdrs[symtab->sh_link].sh_offset);
+    int count = symtab->sh_size / sizeof(Elf32_Sym);
+    struct SymbolUsage *symbols = calloc(count, sizeof(*symbols));
+
+    *symbolsCount = 0;
+    for (int i = 0; i < count; i++)
+    {
+        int type = ELF32_ST_TYPE(syms[i].st_info);
+        if ((type != STT_OBJECT && type != STT_FUNC) || syms[i].st_size == 0)
+            continue;
+        int region = GetRegion(syms[i].st_value);
+        if (region < 0)
+            continue;
+        symbols[*symbolsCount].name = strtab + syms[i].st_name;
+        symbols[*symbolsCount].region = region;
+        symbols[*symbolsCount].size = syms[i].st_size;
+        (*symbolsCount)++;
+    }
+
+    return symbols;
+}
+
+static bool ParseHex(const char *s, uint32_t *value)
+{
+    char *end;
+    if (strncmp(s, "0x", 2) != 0)
+        return false;
+    *value = strtoul(s, &end, 16);
+    return *end == '\0';
+}
+
+// Adds up the input sections of each object, e.g.
+//  .text          0x08000248      0x1f4 src/main.o
+// which ld wraps after long section names.
+static void ReadMap(const char *path)
+{
+    long size;
+    char *map = (char *)ReadWholeFile(path, &size);
+    char *line = strstr(map, "Linker script and memory map");
+    char *pendingSection = NULL;
+
+    if (line == NULL)
+        FATAL_ERROR("error: \"%s\" is not a linker map\n", path);
+
+    while (line != NULL)
+    {
+        char *next = strchr(line, '\n');
+        if (next != NULL)
+            *next++ = '\0';
+
+        char *fields[4];
+        int fieldsCount = 0;
+        bool indented = line[0] == ' ';
+        for (char *field = strtok(line, " \t\r"); field != NULL && fieldsCount < 4; field = strtok(NULL, " \t\r"))
+            fields[fieldsCount++] = field;
+
+        uint32_t address, sectionSize;
+        if (pendingSection != NULL && fieldsCount >= 2 && ParseHex(fields[0], &address) && ParseHex(fields[1], &sectionSize))
+        {
+            // The rest of a wrapped input section.
+            memmove(fields + 1, fields, sizeof(fields) - sizeof(fields[0]));
+            fieldsCount = fieldsCount < 4 ? fieldsCount + 1 : 4;
+            fields[0] = pendingSection;
+        }
+        pendingSection = NULL;
+
+        if (indented && fieldsCount == 1 && fields[0][0] == '.')
+        {
+            pendingSection = fields[0];
+        }
+        else if (indented && fieldsCount >= 3 && fields[0][0] != '*' && ParseHex(fields[1], &address) && ParseHex(fields[2], &sectionSize))
+        {
+            int region = GetRegion(address);
+            if (region >= 0 && sectionSize != 0)
+                GetObject(fieldsCount == 4 ? fields[3] : "*script*", region)->size += sectionSize;
+        }
+        else if (indented && fieldsCount >= 3 && strcmp(fields[0], "*fill*") == 0 && ParseHex(fields[1], &address) && ParseHex(fields[2], &sectionSize))
+        {
+            int region = GetRegion(address);
+            if (region >= 0)
+                GetObject("*fill*", region)->size += sectionSize;
+        }
+
+        line = next;
+    }
+}
+
+static void ReadBaseline(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    char kind[16], region[16], name[1024];
+    unsigned long size;
+
+    if (fp == NULL)
+        FATAL_ERROR("error: failed to open \"%s\" for reading, write one with --write-baseline\n", path);
+
+    while (fscanf(fp, "%15s %15s", kind, region) == 2)
+    {
+        int r = GetRegionByName(region);
+        if (strcmp(kind, "region") == 0 && fscanf(fp, "%lu", &size) == 1 && r >= 0)
+            sRegions[r].baseline = size;
+        else if (strcmp(kind, "object") == 0 && fscanf(fp, "%1023s %lu", name, &size) == 2 && r >= 0)
+            GetObject(name, r)->baseline = size;
+        else
+            FATAL_ERROR("error: \"%s\" is not a baseline\n", path);
+    }
+
+    fclose(fp);
+    sHasBaseline = true;
+}
+
+static void WriteBaseline(const char *path)
+{
+    FILE *fp = fopen(path, "w");
+
+    if (fp == NULL)
+        FATAL_ERROR("error: failed to open \"%s\" for writing\n", path);
+
+    for (int i = 0; i < REGIONS_COUNT; i++)
+        fprintf(fp, "region %s %u\n", sRegions[i].name, sRegions[i].used);
+    for (int i = 0; i < OBJECTS_HASH_SIZE; i++)
+    {
+        if (sObjects[i] != NULL && sObjects[i]->size != 0)
+            fprintf(fp, "object %s %s %u\n", sRegions[sObjects[i]->region].name, sObjects[i]->name, sObjects[i]->size);
+    }
+
+    fclose(fp);
+}
+
+static int CompareObjects(const void *a, const void *b)
+{
+    const struct ObjectUsage *objectA = *(const struct ObjectUsage **)a;
+    const struct ObjectUsage *objectB = *(const struct ObjectUsage **)b;
+    if (objectA->size != objectB->size)
+        return objectA->size < objectB->size ? 1 : -1;
+    return strcmp(objectA->name, objectB->name);
+}
+
+static int64_t Delta(const struct ObjectUsage *object)
+{
+    return (int64_t)object->size - object->baseline;
+}
+
+static int CompareObjectDeltas(const void *a, const void *b)
+{
+    int64_t deltaA = llabs(Delta(*(const struct ObjectUsage **)a));
+    int64_t deltaB = llabs(Delta(*(const struct ObjectUsage **)b));
+    if (deltaA != deltaB)
+        return deltaA < deltaB ? 1 : -1;
+    return CompareObjects(a, b);
+}
+
+static int CompareSymbols(const void *a, const void *b)
+{
+    const struct SymbolUsage *symbolA = a;
+    const struct SymbolUsage *symbolB = b;
+    if (symbolA->size != symbolB->size)
+        return symbolA->size < symbolB->size ? 1 : -1;
+    return strcmp(symbolA->name, symbolB->name);
+}
+
+static void PrintRegion(enum Region region, struct ObjectUsage **objects, int objectsCount, struct SymbolUsage *symbols, int symbolsCount, int top)
+{
+    const struct RegionInfo *info = &sRegions[region];
+    uint32_t attributed = 0;
+    int n;
+
+    printf("%s: %u / %u bytes (%.1f%%)", info->name, info->used, info->capacity, 100.0 * info->used / info->capacity);
+    if (sHasBaseline)
+        printf(", %+lld since baseline", (long long)info->used - info->baseline);
+    if (info->budget != 0)
+        printf(", budget %u", info->budget);
+    if (info->initialized != 0)
+        printf(", %u copied from ROM at boot", info->initialized);
+    printf("\n");
+
+    qsort(objects, objectsCount, sizeof(objects[0]), CompareObjects);
+    printf("  Largest objects:\n");
+    n = 0;
+    for (int i = 0; i < objectsCount; i++)
+    {
+        if (objects[i]->region != region)
+            continue;
+        attributed += objects[i]->size;
+        if (n++ < top && objects[i]->size != 0)
+            printf("    %8u  %s\n", objects[i]->size, objects[i]->name);
+    }
+    if (info->used > attributed)
+        printf("    %8u  (not in any object, e.g. RAM initializer copies)\n", info->used - attributed);
+
+    printf("  Largest symbols:\n");
+    n = 0;
+    for (int i = 0; i < symbolsCount && n < top; i++)
+    {
+        if (symbols[i].region != region)
+            continue;
+        printf("    %8u  %s\n", symbols[i].size, symbols[i].name);
+        n++;
+    }
+
+    if (sHasBaseline)
+    {
+        qsort(objects, objectsCount, sizeof(objects[0]), CompareObjectDeltas);
+        printf("  Largest changes since baseline:\n");
+        n = 0;
+        for (int i = 0; i < objectsCount && n < top; i++)
+        {
+            if (objects[i]->region != region || Delta(objects[i]) == 0)
+                continue;
+            printf("    %+8lld  %s\n", (long long)Delta(objects[i]), objects[i]->name);
+            n++;
+        }
+        if (n == 0)
+            printf("    none\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *baselinePath = NULL;
+    const char *writeBaselinePath = NULL;
+    const char *elfPath = NULL;
+    const char *mapPath = NULL;
+    int top = 10;
+    bool overBudget = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--top") == 0 && i + 1 < argc)
+        {
+            top = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+        {
+            baselinePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--write-baseline") == 0 && i + 1 < argc)
+        {
+            writeBaselinePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc)
+        {
+            char *budget = argv[++i];
+            char *equals = strchr(budget, '=');
+            int region;
+            if (equals == NULL)
+                FATAL_ERROR("error: expected REGION=BYTES, not \"%s\"\n", budget);
+            *equals = '\0';
+            if ((region = GetRegionByName(budget)) < 0)
+                FATAL_ERROR("error: unknown region \"%s\"\n", budget);
+            sRegions[region].budget = strtoul(equals + 1, NULL, 0);
+        }
+        else if (argv[i][0] == '-')
+        {
+            FATAL_ERROR("error: unknown option \"%s\"\n", argv[i]);
+        }
+        else if (elfPath == NULL)
+        {
+            elfPath = argv[i];
+        }
+        else if (mapPath == NULL)
+        {
+            mapPath = argv[i];
+        }
+        else
+        {
+            FATAL_ERROR("error: unexpected argument \"%s\"\n", argv[i]);
+        }
+    }
+
+    if (elfPath == NULL || mapPath == NULL)
+        FATAL_ERROR("Usage: memreport [--top N] [--baseline FILE] [--write-baseline FILE] [--budget REGION=BYTES]... ELF MAP\n");
+
+    int symbolsCount;
+    struct SymbolUsage *symbols = ReadElf(elfPath, &symbolsCount);
+    qsort(symbols, symbolsCount, sizeof(*symbols), CompareSymbols);
+    ReadMap(mapPath);
+    if (baselinePath != NULL)
+        ReadBaseline(baselinePath);
+
+    struct ObjectUsage **objects = calloc(sObjectsCount, sizeof(*objects));
+    int objectsCount = 0;
+    for (int i = 0; i < OBJECTS_HASH_SIZE; i++)
+    {
+        if (sObjects[i] != NULL)
+            objects[objectsCount++] = sObjects[i];
+    }
+
+    for (int i = 0; i < REGIONS_COUNT; i++)
+    {
+        PrintRegion(i, objects, objectsCount, symbols, symbolsCount, top);
+        if (sRegions[i].budget != 0 && sRegions[i].used > sRegions[i].budget)
+        {
+            fprintf(stderr, "memreport: %s uses %u bytes, %u over its budget of %u\n",
+                    sRegions[i].name, sRegions[i].used, sRegions[i].used - sRegions[i].budget, sRegions[i].budget);
+            overBudget = true;
+        }
+    }
+
+    if (writeBaselinePath != NULL)
+        WriteBaseline(writeBaselinePath);
+
+    return overBudget ? 1 : 0;
+}
@@ -14,7 +14,34 @@
  * P/K/F/A: Sets the result to the remaining of the line, flushes any
  *    output since the previous P/K/F/A and increment the number of
  *    passes/known fails/assumption fails/fails.
+ * S: Marks the start of the current test. Used to measure the host wall
+ *    time taken by the test. If followed by "i/n" the test is shard i of
+ *    n, and the result of the test is only reported once all n shards
+ *    have reported their results.
+ * Q: Adds the observed ratio of a range of PASSES_RANDOMLY trials to the
+ *    current sharded test, as "parameter observed expected tolerance".
+ * B: Reports a benchmark of the current test, as "cycles name". If the
+ *    benchmark is slower than its baseline the test fails.
+ * C: Adds to a counter of the current test, as "value name".
+ * H: Adds samples to a histogram of the current test, as "value count
+ *    name", where value is the (upper bound of the) samples' value.
+ *    Counters and histograms are summed over the shards of a test, and
+ *    printed with its result.
+ * D: Sets the number of frames the current test took to the remainder
+ *    of the line.
+ *
+ * OPTIONS
+ * --junit=FILE: Writes a JUnit XML report of every test to FILE.
+ * --json=FILE: Writes a JSON report of every test to FILE.
+ * --baseline=FILE: Reads benchmark baselines from FILE, one
+ *    "test name: benchmark name<TAB>cycles" per line. Lines starting
+ *    with '#' are comments.
+ * --baseline-tolerance=PERCENT: How much slower than its baseline a
+ *    benchmark can be before it fails. Defaults to 5.
+ * --update-baseline: Writes the benchmarks to the baseline FILE instead
+ *    of failing tests which regressed.
  */
+#include <errno.h>
 #include <fcntl.h>
 #include <math.h>
 #include <poll.h>
@@ -32,6 +59,7 @@
 #endif
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 #include "elf.h"
 
@@ -43,6 +71,27 @@
 
 #define ARRAY_COUNT(arr) (sizeof((arr)) / sizeof((arr)[0]))
 
+struct BinCount
+{
+    long value;
+    long count;
+};
+
+// A counter (with no bins) or a histogram of the current test.
+struct Stat
+{
+    char *name;
+    long value;
+    size_t bins_n;
+    struct BinCount *bins;
+};
+
+struct Stats
+{
+    size_t n;
+    struct Stat *stats;
+};
+
 struct Runner
 {
     pid_t pid;
@@ -50,6 +99,12 @@ struct Runner
     char rom_path[FILENAME_MAX];
     char test_name[256];
     char filename_line[256];
+    char test_filename_line[256];
+    struct timespec test_start;
+    int test_frames;
+    int test_shards;
+    bool benchmark_regressed;
+    struct Stats stats;
     size_t input_buffer_size;
     size_t input_buffer_capacity;
     char *input_buffer;
@@ -71,6 +126,54 @@ struct Runner
     char assumeFailed_FilenameLine[MAX_SUMMARY_TESTS_TO_LIST][MAX_TEST_LIST_BUFFER_LENGTH];
 };
 
+struct Report
+{
+    char *test_name;
+    char *filename_line;
+    char *failure_filename_line;
+    char *result;
+    char *output;
+    char command;
+    int runner;
+    int frames;
+    double seconds;
+};
+
+struct ShardRatio
+{
+    int parameter;
+    int observed;
+    int expected;
+    int tolerance;
+};
+
+// A test whose shards run on several runners.
+struct ShardedTest
+{
+    char *filename_line;
+    char *test_name;
+    char *failure_filename_line;
+    char *result;
+    char command;
+    int shards;
+    int shards_reported;
+    int runner;
+    int frames;
+    double seconds;
+    size_t output_size;
+    size_t output_capacity;
+    char *output;
+    size_t ratios_n;
+    struct ShardRatio *ratios;
+    struct Stats stats;
+};
+
+struct Benchmark
+{
+    char *name;
+    long cycles;
+};
+
 struct Symbol {
     const char *name;
     uint32_t address;
@@ -86,6 +189,28 @@ static unsigned nrunners = 0;
 static unsigned runners_digits = 0;
 static struct Runner *runners = NULL;
 
+static const char *junit_path = NULL;
+static const char *json_path = NULL;
+static size_t reports_n = 0;
+static size_t reports_c = 0;
+static struct Report *reports = NULL;
+
+static size_t sharded_tests_n = 0;
+static size_t sharded_tests_c = 0;
+static struct ShardedTest *sharded_tests = NULL;
+
+static const char *baseline_path = NULL;
+static bool update_baseline = false;
+static int baseline_tolerance = 5;
+static size_t baseline_n = 0;
+static struct Benchmark *baseline = NULL;
+static size_t benchmarks_n = 0;
+static struct Benchmark *benchmarks = NULL;
+
+// The exit code for failures detected by Hydra rather than by the
+// runners, e.g. merged shards or benchmark regressions.
+static int hydra_exit_code = 0;
+
 // TODO: Build the symbol table on demand.
 static struct SymbolTable symbol_table = { NULL, 0 };
 
@@ -190,6 +315,735 @@ static void fprint_buffer(FILE *f, const char *buffer, size_t size)
     }
 }
 
+static char *xstrndup(const char *s, size_t n)
+{
+    char *d = malloc(n + 1);
+    if (!d)
+    {
+        perror("malloc xstrndup failed");
+        exit(2);
+    }
+    memcpy(d, s, n);
+    d[n] = '\0';
+    return d;
+}
+
+// Copies the result, e.g. "\e[32mPASS\e[0m", without its escape sequences.
+static char *strip_escapes(const char *s, size_t n)
+{
+    char *d = xstrndup(s, n);
+    char *o = d;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (s[i] == '\e')
+        {
+            while (i < n && !(s[i] >= '@' && s[i] <= '~' && s[i] != '['))
+                i++;
+        }
+        else if (s[i] != '\n')
+        {
+            *o++ = s[i];
+        }
+    }
+    *o = '\0';
+    return d;
+}
+
+static double elapsed_seconds(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void add_report(int i, struct Runner *runner, char command, const char *result, size_t result_size, double seconds)
+{
+    if (!junit_path && !json_path)
+        return;
+
+    if (reports_n == reports_c)
+    {
+        reports_c = reports_c ? reports_c * 2 : 1024;
+        reports = realloc(reports, reports_c * sizeof(*reports));
+        if (!reports)
+        {
+            perror("realloc reports failed");
+            exit(2);
+        }
+    }
+
+    struct Report *report = &reports[reports_n++];
+    report->test_name = strdup(runner->test_name);
+    if (runner->test_filename_line[0])
+        report->filename_line = strdup(runner->test_filename_line);
+    else
+        report->filename_line = strdup(runner->filename_line);
+    report->failure_filename_line = strdup(runner->filename_line);
+    report->result = strip_escapes(result, result_size);
+    if (command == 'F' || command == 'U')
+        report->output = strip_escapes(runner->output_buffer, runner->output_buffer_size);
+    else
+        report->output = NULL;
+    report->command = command;
+    report->runner = i;
+    report->frames = runner->test_frames;
+    report->seconds = seconds;
+}
+
+static void fprint_json_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s; s++)
+    {
+        switch (*s)
+        {
+        case '"':  fputs("\\\"", f); break;
+        case '\\': fputs("\\\\", f); break;
+        case '\n': fputs("\\n", f); break;
+        case '\t': fputs("\\t", f); break;
+        default:
+            if ((unsigned char)*s < 0x20)
+                fprintf(f, "\\u%04x", (unsigned char)*s);
+            else
+                fputc(*s, f);
+            break;
+        }
+    }
+    fputc('"', f);
+}
+
+static void fprint_xml_string(FILE *f, const char *s)
+{
+    for (; *s; s++)
+    {
+        switch (*s)
+        {
+        case '"':  fputs("&quot;", f); break;
+        case '&':  fputs("&amp;", f); break;
+        case '\'': fputs("&apos;", f); break;
+        case '<':  fputs("&lt;", f); break;
+        case '>':  fputs("&gt;", f); break;
+        default:
+            // XML 1.0 does not allow most control characters.
+            if ((unsigned char)*s >= 0x20 || *s == '\n' || *s == '\t')
+                fputc(*s, f);
+            break;
+        }
+    }
+}
+
+// Splits "filename:line" into its parts. line is 0 if it is missing.
+static void split_filename_line(const char *filename_line, char *filename, size_t filename_size, int *line)
+{
+    const char *colon = strchr(filename_line, ':');
+    size_t n = colon ? (size_t)(colon - filename_line) : strlen(filename_line);
+    if (n >= filename_size)
+        n = filename_size - 1;
+    memcpy(filename, filename_line, n);
+    filename[n] = '\0';
+    *line = colon ? atoi(colon + 1) : 0;
+}
+
+static const char *report_status(const struct Report *report)
+{
+    switch (report->command)
+    {
+    case 'P': return "pass";
+    case 'K': return "known_failing";
+    case 'U': return "known_failing_pass";
+    case 'T': return "todo";
+    case 'A': return "assumption_fail";
+    default:  return "fail";
+    }
+}
+
+static void write_json_report(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        perror("fopen json report failed");
+        exit(2);
+    }
+
+    fprintf(f, "{\n  \"runners\": %u,\n  \"tests\": [", nrunners);
+    for (size_t i = 0; i < reports_n; i++)
+    {
+        const struct Report *report = &reports[i];
+        char filename[256];
+        int line;
+        split_filename_line(report->filename_line, filename, sizeof(filename), &line);
+        fprintf(f, "%s\n    {\"name\": ", i == 0 ? "" : ",");
+        fprint_json_string(f, report->test_name);
+        fprintf(f, ", \"file\": ");
+        fprint_json_string(f, filename);
+        fprintf(f, ", \"line\": %d, \"status\": \"%s\", \"result\": ", line, report_status(report));
+        fprint_json_string(f, report->result);
+        fprintf(f, ", \"runner\": %d, \"frames\": %d, \"seconds\": %.3f", report->runner, report->frames, report->seconds);
+        if (report->output)
+        {
+            fprintf(f, ", \"location\": ");
+            fprint_json_string(f, report->failure_filename_line);
+            fprintf(f, ", \"output\": ");
+            fprint_json_string(f, report->output);
+        }
+        fprintf(f, "}");
+    }
+    fprintf(f, "\n  ]\n}\n");
+
+    if (fclose(f) != 0)
+    {
+        perror("fclose json report failed");
+        exit(2);
+    }
+}
+
+static void write_junit_report(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        perror("fopen junit report failed");
+        exit(2);
+    }
+
+    int failures = 0, skipped = 0;
+    double seconds = 0;
+    for (size_t i = 0; i < reports_n; i++)
+    {
+        switch (reports[i].command)
+        {
+        case 'P': break;
+        case 'K': case 'T': case 'A': skipped++; break;
+        default: failures++; break;
+        }
+        seconds += reports[i].seconds;
+    }
+
+    fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    fprintf(f, "<testsuites tests=\"%zu\" failures=\"%d\" skipped=\"%d\" time=\"%.3f\">\n", reports_n, failures, skipped, seconds);
+    fprintf(f, "  <testsuite name=\"mgba-rom-test\" tests=\"%zu\" failures=\"%d\" skipped=\"%d\" time=\"%.3f\">\n", reports_n, failures, skipped, seconds);
+    for (size_t i = 0; i < reports_n; i++)
+    {
+        const struct Report *report = &reports[i];
+        char filename[256];
+        int line;
+        split_filename_line(report->filename_line, filename, sizeof(filename), &line);
+        fprintf(f, "    <testcase classname=\"");
+        fprint_xml_string(f, filename);
+        fprintf(f, "\" name=\"");
+        fprint_xml_string(f, report->test_name);
+        fprintf(f, "\" file=\"");
+        fprint_xml_string(f, filename);
+        fprintf(f, "\" line=\"%d\" time=\"%.3f\">\n", line, report->seconds);
+        fprintf(f, "      <properties>\n");
+        fprintf(f, "        <property name=\"runner\" value=\"%d\"/>\n", report->runner);
+        fprintf(f, "        <property name=\"frames\" value=\"%d\"/>\n", report->frames);
+        fprintf(f, "      </properties>\n");
+        switch (report->command)
+        {
+        case 'P':
+            break;
+        case 'K': case 'T': case 'A':
+            fprintf(f, "      <skipped message=\"");
+            fprint_xml_string(f, report->result);
+            fprintf(f, "\"/>\n");
+            break;
+        default:
+            fprintf(f, "      <failure message=\"");
+            fprint_xml_string(f, report->result);
+            fprintf(f, "\" type=\"");
+            fprint_xml_string(f, report->result);
+            fprintf(f, "\">");
+            fprint_xml_string(f, report->failure_filename_line);
+            if (report->output)
+            {
+                fprintf(f, "\n");
+                fprint_xml_string(f, report->output);
+            }
+            fprintf(f, "</failure>\n");
+            break;
+        }
+        fprintf(f, "    </testcase>\n");
+    }
+    fprintf(f, "  </testsuite>\n</testsuites>\n");
+
+    if (fclose(f) != 0)
+    {
+        perror("fclose junit report failed");
+        exit(2);
+    }
+}
+
+static void append_buffer(char **buffer, size_t *size, size_t *capacity, const char *s, size_t n)
+{
+    if (*size + n >= *capacity)
+    {
+        *capacity = *capacity ? *capacity * 2 : 4096;
+        if (*capacity < *size + n)
+            *capacity = *size + n;
+        *buffer = realloc(*buffer, *capacity);
+        if (!*buffer)
+        {
+            perror("realloc buffer failed");
+            exit(2);
+        }
+    }
+    memcpy(*buffer + *size, s, n);
+    *size += n;
+}
+
+// Counts, reports, and prints the result of the runner's current test.
+static void record_result(int i, struct Runner *runner, char command, const char *result, size_t result_size, double seconds)
+{
+    switch (command)
+    {
+    case 'P':
+        runner->passes++;
+        break;
+    case 'K':
+        runner->knownFails++;
+        break;
+    case 'U':
+        if (runner->knownFailsPassing < MAX_SUMMARY_TESTS_TO_LIST)
+        {
+            strcpy(runner->knownFailingPassed_TestNames[runner->knownFailsPassing], runner->test_name);
+            strcpy(runner->knownFailingPassed_FilenameLine[runner->knownFailsPassing], runner->filename_line);
+        }
+        runner->knownFailsPassing++;
+        break;
+    case 'T':
+        runner->todos++;
+        break;
+    case 'A':
+        if (runner->assumptionFails < MAX_SUMMARY_TESTS_TO_LIST)
+        {
+            strcpy(runner->assumeFailed_TestNames[runner->assumptionFails], runner->test_name);
+            strcpy(runner->assumeFailed_FilenameLine[runner->assumptionFails], runner->filename_line);
+        }
+        runner->assumptionFails++;
+        break;
+    case 'F':
+        if (runner->fails < MAX_SUMMARY_TESTS_TO_LIST)
+        {
+            strcpy(runner->failed_TestNames[runner->fails], runner->test_name);
+            strcpy(runner->failed_TestFilenameLine[runner->fails], runner->filename_line);
+        }
+        runner->fails++;
+        break;
+    }
+    runner->results++;
+    add_report(i, runner, command, result, result_size, seconds);
+    fprintf(stdout, "[%0*d] %s: ", runners_digits, i, runner->test_name);
+    fwrite(result, 1, result_size, stdout);
+    fprint_buffer(stdout, runner->output_buffer, runner->output_buffer_size);
+    strcpy(runner->test_name, "WAITING...");
+    runner->test_filename_line[0] = '\0';
+    runner->test_frames = 0;
+    runner->test_shards = 1;
+    clock_gettime(CLOCK_MONOTONIC, &runner->test_start);
+    runner->output_buffer_size = 0;
+}
+
+static struct ShardedTest *find_sharded_test(const char *filename_line, int shards)
+{
+    for (size_t i = 0; i < sharded_tests_n; i++)
+    {
+        if (strcmp(sharded_tests[i].filename_line, filename_line) == 0)
+            return &sharded_tests[i];
+    }
+
+    if (sharded_tests_n == sharded_tests_c)
+    {
+        sharded_tests_c = sharded_tests_c ? sharded_tests_c * 2 : 64;
+        sharded_tests = realloc(sharded_tests, sharded_tests_c * sizeof(*sharded_tests));
+        if (!sharded_tests)
+        {
+            perror("realloc sharded_tests failed");
+            exit(2);
+        }
+    }
+
+    struct ShardedTest *test = &sharded_tests[sharded_tests_n++];
+    memset(test, 0, sizeof(*test));
+    test->filename_line = strdup(filename_line);
+    test->command = 'P';
+    test->shards = shards;
+    return test;
+}
+
+static void add_shard_ratio(struct Runner *runner, const char *s)
+{
+    struct ShardRatio ratio;
+    if (sscanf(s, "%d %d %d %d", &ratio.parameter, &ratio.observed, &ratio.expected, &ratio.tolerance) != 4)
+    {
+        fprintf(stderr, "malformed ratio\n");
+        exit(2);
+    }
+
+    struct ShardedTest *test = find_sharded_test(runner->test_filename_line, runner->test_shards);
+    for (size_t i = 0; i < test->ratios_n; i++)
+    {
+        if (test->ratios[i].parameter == ratio.parameter)
+        {
+            test->ratios[i].observed += ratio.observed;
+            return;
+        }
+    }
+    test->ratios = realloc(test->ratios, (test->ratios_n + 1) * sizeof(*test->ratios));
+    if (!test->ratios)
+    {
+        perror("realloc ratios failed");
+        exit(2);
+    }
+    test->ratios[test->ratios_n++] = ratio;
+}
+
+static struct Stat *find_stat(struct Stats *stats, const char *name, size_t name_n)
+{
+    for (size_t i = 0; i < stats->n; i++)
+    {
+        if (strlen(stats->stats[i].name) == name_n && memcmp(stats->stats[i].name, name, name_n) == 0)
+            return &stats->stats[i];
+    }
+
+    stats->stats = realloc(stats->stats, (stats->n + 1) * sizeof(*stats->stats));
+    if (!stats->stats)
+    {
+        perror("realloc stats failed");
+        exit(2);
+    }
+    struct Stat *stat = &stats->stats[stats->n++];
+    memset(stat, 0, sizeof(*stat));
+    stat->name = xstrndup(name, name_n);
+    return stat;
+}
+
+// The stats of a sharded test are summed over its shards.
+static struct Stats *runner_stats(struct Runner *runner)
+{
+    if (runner->test_shards > 1)
+        return &find_sharded_test(runner->test_filename_line, runner->test_shards)->stats;
+    return &runner->stats;
+}
+
+static void add_counter(struct Runner *runner, const char *s, size_t n)
+{
+    char *end;
+    long value = strtol(s, &end, 10);
+    if (end == s || *end != ' ')
+    {
+        fprintf(stderr, "malformed counter\n");
+        exit(2);
+    }
+    end++;
+    find_stat(runner_stats(runner), end, s + n - end)->value += value;
+}
+
+static void add_histogram_bin(struct Runner *runner, const char *s, size_t n)
+{
+    char *end;
+    long value = strtol(s, &end, 10);
+    long count = strtol(end, &end, 10);
+    if (end == s || *end != ' ')
+    {
+        fprintf(stderr, "malformed histogram\n");
+        exit(2);
+    }
+    end++;
+
+    struct Stat *stat = find_stat(runner_stats(runner), end, s + n - end);
+    stat->value += count;
+    for (size_t i = 0; i < stat->bins_n; i++)
+    {
+        if (stat->bins[i].value == value)
+        {
+            stat->bins[i].count += count;
+            return;
+        }
+    }
+    stat->bins = realloc(stat->bins, (stat->bins_n + 1) * sizeof(*stat->bins));
+    if (!stat->bins)
+    {
+        perror("realloc bins failed");
+        exit(2);
+    }
+    stat->bins[stat->bins_n].value = value;
+    stat->bins[stat->bins_n].count = count;
+    stat->bins_n++;
+}
+
+static int compare_bins(const void *a, const void *b)
+{
+    const struct BinCount *ba = a, *bb = b;
+    return (ba->value > bb->value) - (ba->value < bb->value);
+}
+
+// Returns an upper bound of the percentile, exact only for max.
+static long histogram_percentile(const struct Stat *stat, long percentile)
+{
+    long count = 0;
+    long rank = (stat->value * percentile + 99) / 100;
+    for (size_t i = 0; i < stat->bins_n; i++)
+    {
+        count += stat->bins[i].count;
+        if (count >= rank)
+            return stat->bins[i].value;
+    }
+    return stat->bins_n ? stat->bins[stat->bins_n - 1].value : 0;
+}
+
+// Appends the counters and histograms to the output, and clears them.
+static void flush_stats(struct Stats *stats, char **buffer, size_t *size, size_t *capacity)
+{
+    for (size_t i = 0; i < stats->n; i++)
+    {
+        struct Stat *stat = &stats->stats[i];
+        char message[1024];
+        int n;
+        if (stat->bins_n == 0)
+        {
+            n = snprintf(message, sizeof(message), "%s: %ld\n", stat->name, stat->value);
+        }
+        else
+        {
+            long total = 0;
+            qsort(stat->bins, stat->bins_n, sizeof(*stat->bins), compare_bins);
+            for (size_t j = 0; j < stat->bins_n; j++)
+                total += stat->bins[j].value * stat->bins[j].count;
+            n = snprintf(message, sizeof(message), "%s: %ld samples, mean <= %ld, p50 <= %ld, p90 <= %ld, p99 <= %ld, max %ld\n",
+                         stat->name, stat->value, stat->value ? total / stat->value : 0,
+                         histogram_percentile(stat, 50), histogram_percentile(stat, 90), histogram_percentile(stat, 99),
+                         stat->bins[stat->bins_n - 1].value);
+        }
+        append_buffer(buffer, size, capacity, message, min((size_t)n, sizeof(message) - 1));
+        free(stat->name);
+        free(stat->bins);
+    }
+    free(stats->stats);
+    memset(stats, 0, sizeof(*stats));
+}
+
+// Orders the results of shards so that the most important one becomes
+// the result of the test, e.g. any failing shard fails the test, and a
+// KNOWN_FAILING test is only passing if all its shards pass.
+static int shard_result_rank(char command)
+{
+    switch (command)
+    {
+    case 'F': return 5;
+    case 'A': return 4;
+    case 'T': return 3;
+    case 'K': return 2;
+    case 'U': return 1;
+    default: return 0;
+    }
+}
+
+static void finish_sharded_test(int i, struct Runner *runner, struct ShardedTest *test)
+{
+    char command = test->command;
+    char *result = test->result;
+
+    for (size_t j = 0; j < test->ratios_n; j++)
+    {
+        const struct ShardRatio *ratio = &test->ratios[j];
+        if (abs(ratio->observed - ratio->expected) > ratio->tolerance)
+        {
+            char message[256];
+            int n = snprintf(message, sizeof(message), "%s: Expected %.3f passes/successes, observed %.3f\n", test->filename_line, ratio->expected / 4096.0, ratio->observed / 4096.0);
+            append_buffer(&test->output, &test->output_size, &test->output_capacity, message, min((size_t)n, sizeof(message) - 1));
+            free(test->failure_filename_line);
+            test->failure_filename_line = xstrndup(message, strcspn(message, "\n"));
+            if (command == 'P')
+            {
+                command = 'F';
+                result = "\e[31mFAIL\e[0m\n";
+            }
+            else if (command == 'U')
+            {
+                command = 'K';
+                result = "\e[33mKNOWN_FAILING\e[0m\n";
+            }
+        }
+    }
+    flush_stats(&test->stats, &test->output, &test->output_size, &test->output_capacity);
+    if (shard_result_rank(command) < shard_result_rank('K') && test->shards_reported < test->shards)
+    {
+        char message[256];
+        int n = snprintf(message, sizeof(message), "%d/%d shards reported\n", test->shards_reported, test->shards);
+        append_buffer(&test->output, &test->output_size, &test->output_capacity, message, min((size_t)n, sizeof(message) - 1));
+        command = 'F';
+        result = "\e[31mINCOMPLETE\e[0m\n";
+    }
+    if (command == 'F' || command == 'U')
+        hydra_exit_code = 1;
+
+    snprintf(runner->test_name, sizeof(runner->test_name), "%s", test->test_name ? test->test_name : "UNKNOWN");
+    snprintf(runner->test_filename_line, sizeof(runner->test_filename_line), "%s", test->filename_line);
+    snprintf(runner->filename_line, sizeof(runner->filename_line), "%s", test->failure_filename_line ? test->failure_filename_line : test->filename_line);
+    runner->test_frames = test->frames;
+    runner->output_buffer_size = 0;
+    append_buffer(&runner->output_buffer, &runner->output_buffer_size, &runner->output_buffer_capacity, test->output, test->output_size);
+    record_result(i, runner, command, result, strlen(result), test->seconds);
+
+    free(test->filename_line);
+    free(test->test_name);
+    free(test->failure_filename_line);
+    free(test->result);
+    free(test->output);
+    free(test->ratios);
+    *test = sharded_tests[--sharded_tests_n];
+}
+
+static void add_shard_result(int i, struct Runner *runner, char command, const char *result, size_t result_size)
+{
+    struct ShardedTest *test = find_sharded_test(runner->test_filename_line, runner->test_shards);
+
+    test->shards_reported++;
+    test->runner = i;
+    test->frames += runner->test_frames;
+    test->seconds += elapsed_seconds(&runner->test_start);
+    if (!test->test_name || shard_result_rank(command) > shard_result_rank(test->command))
+    {
+        free(test->test_name);
+        test->test_name = strdup(runner->test_name);
+    }
+    if (!test->result || shard_result_rank(command) > shard_result_rank(test->command))
+    {
+        free(test->result);
+        test->result = xstrndup(result, result_size);
+        test->command = command;
+        if (command != 'P' && command != 'U')
+        {
+            free(test->failure_filename_line);
+            test->failure_filename_line = strdup(runner->filename_line);
+        }
+    }
+    if (command == 'F' || command == 'K')
+        append_buffer(&test->output, &test->output_size, &test->output_capacity, runner->output_buffer, runner->output_buffer_size);
+
+    strcpy(runner->test_name, "WAITING...");
+    runner->test_filename_line[0] = '\0';
+    runner->test_frames = 0;
+    runner->test_shards = 1;
+    clock_gettime(CLOCK_MONOTONIC, &runner->test_start);
+    runner->output_buffer_size = 0;
+
+    if (test->shards_reported == test->shards)
+        finish_sharded_test(i, runner, test);
+}
+
+static struct Benchmark *find_benchmark(struct Benchmark *benchmarks, size_t benchmarks_n, const char *name)
+{
+    for (size_t i = 0; i < benchmarks_n; i++)
+    {
+        if (strcmp(benchmarks[i].name, name) == 0)
+            return &benchmarks[i];
+    }
+    return NULL;
+}
+
+static void add_benchmark(struct Benchmark **benchmarks, size_t *benchmarks_n, const char *name, long cycles)
+{
+    *benchmarks = realloc(*benchmarks, (*benchmarks_n + 1) * sizeof(**benchmarks));
+    if (!*benchmarks)
+    {
+        perror("realloc benchmarks failed");
+        exit(2);
+    }
+    (*benchmarks)[*benchmarks_n].name = strdup(name);
+    (*benchmarks)[*benchmarks_n].cycles = cycles;
+    (*benchmarks_n)++;
+}
+
+static void read_baseline(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        // Missing until the first --update-baseline.
+        if (errno == ENOENT)
+            return;
+        perror("fopen baseline failed");
+        exit(2);
+    }
+
+    char line[1024];
+    while (fgets(line, sizeof(line), f))
+    {
+        char *tab = strrchr(line, '\t');
+        if (line[0] == '#' || !tab)
+            continue;
+        *tab = '\0';
+        add_benchmark(&baseline, &baseline_n, line, strtol(tab + 1, NULL, 10));
+    }
+    fclose(f);
+}
+
+static int compare_benchmarks(const void *a, const void *b)
+{
+    const struct Benchmark *ba = a, *bb = b;
+    return strcmp(ba->name, bb->name);
+}
+
+// Writes the measured benchmarks, and keeps the baseline of any which
+// did not run.
+static void write_baseline(const char *path)
+{
+    for (size_t i = 0; i < baseline_n; i++)
+    {
+        if (!find_benchmark(benchmarks, benchmarks_n, baseline[i].name))
+            add_benchmark(&benchmarks, &benchmarks_n, baseline[i].name, baseline[i].cycles);
+    }
+    qsort(benchmarks, benchmarks_n, sizeof(*benchmarks), compare_benchmarks);
+
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        perror("fopen baseline failed");
+        exit(2);
+    }
+    fprintf(f, "# Benchmark cycles which EXPECT_BASELINE compares against.\n");
+    fprintf(f, "# Regenerate with `make check UPDATE_BASELINE=1`.\n");
+    for (size_t i = 0; i < benchmarks_n; i++)
+        fprintf(f, "%s\t%ld\n", benchmarks[i].name, benchmarks[i].cycles);
+    if (fclose(f) != 0)
+    {
+        perror("fclose baseline failed");
+        exit(2);
+    }
+}
+
+static void handle_benchmark(struct Runner *runner, const char *s, size_t n)
+{
+    char *end;
+    long cycles = strtol(s, &end, 10);
+    if (end == s || *end != ' ')
+    {
+        fprintf(stderr, "malformed benchmark\n");
+        exit(2);
+    }
+    end++;
+
+    char name[512];
+    snprintf(name, sizeof(name), "%s: %.*s", runner->test_name, (int)(s + n - end), end);
+    if (find_benchmark(benchmarks, benchmarks_n, name))
+        return;
+    add_benchmark(&benchmarks, &benchmarks_n, name, cycles);
+
+    const struct Benchmark *base = find_benchmark(baseline, baseline_n, name);
+    if (!base || base->cycles <= 0)
+        return;
+
+    double delta = 100.0 * (cycles - base->cycles) / base->cycles;
+    char message[1024];
+    int message_n = snprintf(message, sizeof(message), "%s: %ld cycles, baseline: %ld cycles (%+.1f%%)\n", name, cycles, base->cycles, delta);
+    append_buffer(&runner->output_buffer, &runner->output_buffer_size, &runner->output_buffer_capacity, message, min((size_t)message_n, sizeof(message) - 1));
+    if (delta > baseline_tolerance && !update_baseline)
+        runner->benchmark_regressed = true;
+}
+
 static void handle_read(int i, struct Runner *runner)
 {
     char *sol = runner->input_buffer;
@@ -235,48 +1089,70 @@ static void handle_read(int i, struct Runner *runner)
                     strncpy(runner->filename_line, soc, eol - soc - 1);
                     runner->filename_line[eol - soc - 1] = '\0';
                     break;
+                case 'S':
+                    strcpy(runner->test_filename_line, runner->filename_line);
+                    clock_gettime(CLOCK_MONOTONIC, &runner->test_start);
+                    runner->test_shards = 1;
+                    if (soc[2] != '\n')
+                    {
+                        int shard;
+                        if (sscanf(soc + 2, "%d/%d", &shard, &runner->test_shards) != 2)
+                        {
+                            fprintf(stderr, "malformed shard\n");
+                            exit(2);
+                        }
+                        find_sharded_test(runner->test_filename_line, runner->test_shards);
+                    }
+                    break;
+                case 'D':
+                    runner->test_frames = atoi(soc + 2);
+                    break;
+
+                case 'Q':
+                    add_shard_ratio(runner, soc + 2);
+                    break;
+                case 'B':
+                    handle_benchmark(runner, soc + 2, eol - soc - 3);
+                    break;
+                case 'C':
+                    add_counter(runner, soc + 2, eol - soc - 3);
+                    break;
+                case 'H':
+                    add_histogram_bin(runner, soc + 2, eol - soc - 3);
+                    break;
 
                 case 'P':
-                    runner->passes++;
-                    goto add_to_results;
                 case 'K':
-                    runner->knownFails++;
-                    goto add_to_results;
                 case 'U':
-                    if (runner->knownFailsPassing < MAX_SUMMARY_TESTS_TO_LIST)
-                    {
-                        strcpy(runner->knownFailingPassed_TestNames[runner->knownFailsPassing], runner->test_name);
-                        strcpy(runner->knownFailingPassed_FilenameLine[runner->knownFailsPassing], runner->filename_line);
-                    }
-                    runner->knownFailsPassing++;
-                    goto add_to_results;
                 case 'T':
-                    runner->todos++;
-                    goto add_to_results;
                 case 'A':
-                    if (runner->assumptionFails < MAX_SUMMARY_TESTS_TO_LIST)
+                case 'F':
+                {
+                    char command = soc[1];
+                    const char *result = soc + 2;
+                    size_t result_size = eol - soc - 2;
+                    if (runner->benchmark_regressed)
                     {
-                        strcpy(runner->assumeFailed_TestNames[runner->assumptionFails], runner->test_name);
-                        strcpy(runner->assumeFailed_FilenameLine[runner->assumptionFails], runner->filename_line);
+                        if (command == 'P')
+                        {
+                            command = 'F';
+                            result = "\e[31mBENCHMARK_REGRESSION\e[0m\n";
+                            result_size = strlen(result);
+                            hydra_exit_code = 1;
+                        }
+                        runner->benchmark_regressed = false;
                     }
-                    runner->assumptionFails++;
-                    goto add_to_results;
-                case 'F':
-                    if (runner->fails < MAX_SUMMARY_TESTS_TO_LIST)
+                    if (runner->test_shards > 1)
                     {
-                        strcpy(runner->failed_TestNames[runner->fails], runner->test_name);
-                        strcpy(runner->failed_TestFilenameLine[runner->fails], runner->filename_line);
+                        add_shard_result(i, runner, command, result, result_size);
+                    }
+                    else
+                    {
+                        flush_stats(&runner->stats, &runner->output_buffer, &runner->output_buffer_size, &runner->output_buffer_capacity);
+                        record_result(i, runner, command, result, result_size, elapsed_seconds(&runner->test_start));
                     }
-                    runner->fails++;
-add_to_results:
-                    runner->results++;
-                    soc += 2;
-                    fprintf(stdout, "[%0*d] %s: ", runners_digits, i, runner->test_name);
-                    fwrite(soc, 1, eol - soc, stdout);
-                    fprint_buffer(stdout, runner->output_buffer, runner->output_buffer_size);
-                    strcpy(runner->test_name, "WAITING...");
-                    runner->output_buffer_size = 0;
                     break;
+                }
 
                 default:
                     goto buffer_output;
@@ -285,20 +1161,7 @@ add_to_results:
             else
             {
 buffer_output:
-                if (runner->output_buffer_size + eol - soc >= runner->output_buffer_capacity)
-                {
-                    runner->output_buffer_capacity *= 2;
-                    if (runner->output_buffer_capacity < runner->output_buffer_size + eol - soc)
-                        runner->output_buffer_capacity = runner->output_buffer_size + eol - soc;
-                    runner->output_buffer = realloc(runner->output_buffer, runner->output_buffer_capacity);
-                    if (!runner->output_buffer)
-                    {
-                        perror("realloc output_buffer failed");
-                        exit(2);
-                    }
-                }
-                memcpy(runner->output_buffer + runner->output_buffer_size, soc, eol - soc);
-                runner->output_buffer_size += eol - soc;
+                append_buffer(&runner->output_buffer, &runner->output_buffer_size, &runner->output_buffer_capacity, soc, eol - soc);
             }
         }
         else
@@ -424,9 +1287,28 @@ error:
 
 int main(int argc, char *argv[])
 {
+    // Consume the options so that argv[1..3] are the positional arguments.
+    int argn = 1;
+    for (int argi = 1; argi < argc; argi++)
+    {
+        if (!strncmp(argv[argi], "--junit=", strlen("--junit=")))
+            junit_path = argv[argi] + strlen("--junit=");
+        else if (!strncmp(argv[argi], "--json=", strlen("--json=")))
+            json_path = argv[argi] + strlen("--json=");
+        else if (!strncmp(argv[argi], "--baseline=", strlen("--baseline=")))
+            baseline_path = argv[argi] + strlen("--baseline=");
+        else if (!strncmp(argv[argi], "--baseline-tolerance=", strlen("--baseline-tolerance=")))
+            baseline_tolerance = atoi(argv[argi] + strlen("--baseline-tolerance="));
+        else if (!strcmp(argv[argi], "--update-baseline"))
+            update_baseline = true;
+        else
+            argv[argn++] = argv[argi];
+    }
+    argc = argn;
+
     if (argc < 4)
     {
-        fprintf(stderr, "usage %s mgba-rom-test objcopy rom\n", argv[0]);
+        fprintf(stderr, "usage %s [--junit=FILE] [--json=FILE] [--baseline=FILE [--baseline-tolerance=PERCENT] [--update-baseline]] mgba-rom-test objcopy rom\n", argv[0]);
         exit(2);
     }
 
@@ -475,6 +1357,9 @@ int main(int argc, char *argv[])
 
     build_symbol_table(elf);
 
+    if (baseline_path)
+        read_baseline(baseline_path);
+
     nrunners = 1;
     const char *makeflags = getenv("MAKEFLAGS");
     if (makeflags)
@@ -514,6 +1399,7 @@ int main(int argc, char *argv[])
         runners[i].output_buffer_capacity = 4096;
         runners[i].output_buffer = malloc(runners[i].output_buffer_capacity);
         strcpy(runners[i].test_name, "WAITING...");
+        clock_gettime(CLOCK_MONOTONIC, &runners[i].test_start);
         if (tty)
             fprintf(stdout, "[%0*d] %s\n", runners_digits, i, runners[i].test_name);
     }
@@ -732,8 +1618,16 @@ int main(int argc, char *argv[])
         }
     }
 
+    // Report any sharded tests which are missing shards, e.g. because a
+    // runner timed out.
+    while (sharded_tests_n > 0)
+    {
+        struct ShardedTest *test = &sharded_tests[sharded_tests_n - 1];
+        finish_sharded_test(test->runner, &runners[test->runner], test);
+    }
+
     // Reap test runners and collate exit codes.
-    int exit_code = 0;
+    int exit_code = hydra_exit_code;
     int passes = 0;
     int knownFails = 0;
     int knownFailsPassing = 0;
@@ -866,6 +1760,13 @@ int main(int argc, char *argv[])
     }
     fprintf(stdout, "\n");
 
+    if (baseline_path && update_baseline)
+        write_baseline(baseline_path);
+    if (junit_path)
+        write_junit_report(junit_path);
+    if (json_path)
+        write_json_report(json_path);
+
     fflush(stdout);
     return exit_code;
 }